@@ -0,0 +1,63 @@
+#ifndef __blobs_h_
+#define __blobs_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "finder.h"
+#include "matchmask.h"
+
+typedef struct Blob_t
+{
+    uint64_t area;
+    int32_t x1, y1, x2, y2;
+    double centreX, centreY;
+} Blob;
+
+typedef struct BlobArray_t
+{
+    Blob *blobs;
+    size_t count;
+} BlobArray;
+
+
+
+/** @brief Finds the 8-connected regions of pixels similar to a colour within a specified area. Matches are collected
+ *         into a MatchMask and labelled as runs of set bits, so no per-pixel points are ever allocated.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target, comparator functions and worker pool to use.
+ * @param blobs BlobArray* A pointer to a BlobArray structure that will contain the blobs in order of their first pixel in row-major order.
+ *                         x1 and y1 are the smallest coordinates of a blob, x2 and y2 one past the largest, and the centre is the
+ *                         mean of its pixels. This structure must be freed using freeBlobArray().
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to match.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @param minArea uint64_t The smallest amount of pixels a blob must hold to be returned.
+ * @return bool Returns true if any blob is found; false if none is found or memory ran out.
+ *
+ */
+extern bool findBlobs(CTSInfo *info, BlobArray *blobs, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance, uint64_t minArea);
+
+
+/** @brief Finds the 8-connected regions of set bits of a mask. See findBlobs() for the layout of the blobs.
+ *
+ * @param mask const MatchMask* A pointer to the mask to label.
+ * @param blobs BlobArray* A pointer to a BlobArray structure that will contain the blobs. This structure must be freed using freeBlobArray().
+ * @param minArea uint64_t The smallest amount of pixels a blob must hold to be returned.
+ * @return bool Returns true if any blob is found; false if none is found or memory ran out.
+ *
+ */
+extern bool findMaskBlobs(const MatchMask *mask, BlobArray *blobs, uint64_t minArea);
+
+
+/** @brief Frees blobs filled by findBlobs() or findMaskBlobs().
+ *
+ * @param blobs BlobArray* Pointer to the structure to be freed.
+ * @return void
+ *
+ */
+extern void freeBlobArray(BlobArray *blobs);
+
+#endif // __blobs_h_
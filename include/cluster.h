@@ -0,0 +1,62 @@
+#ifndef __cluster_h_
+#define __cluster_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "points.h"
+
+typedef struct PointCluster_t
+{
+    PointArray points;
+    int32_t x1, y1, x2, y2;
+    double centreX, centreY;
+} PointCluster;
+
+typedef struct PointClusters_t
+{
+    PointCluster *clusters;
+    size_t count;
+} PointClusters;
+
+
+
+/** @brief Groups points around seeds. Each point joins the earliest cluster whose first point lies within distance
+ *         of it, or starts a new cluster otherwise. Seeds are looked up in a grid of cells, so this runs in O(n).
+ *
+ * @param points const PointArray* A pointer to the points to group.
+ * @param distance double The largest Euclidean distance from a cluster's first point at which a point joins it.
+ * @param clusters PointClusters* A pointer to a PointClusters structure that will contain the clusters in order of their first point.
+ *                                Points keep their input order. x1 and y1 are the smallest coordinates of a cluster, x2 and y2
+ *                                one past the largest, and the centre is the mean of its points.
+ *                                This structure must be freed using freePointClusters().
+ * @return bool Returns true if the points were grouped; false if memory ran out.
+ *
+ */
+extern bool clusterPoints(const PointArray *points, double distance, PointClusters *clusters);
+
+
+/** @brief Splits points into connected groups. Two points share a cluster if a chain of points, each within distance
+ *         of the next, joins them. Points are unioned through a grid of cells and neighbouring cells are compared
+ *         only through their outermost points per row or column, so this runs in O(n), also for dense groups lying
+ *         just out of reach of each other.
+ *
+ * @param points const PointArray* A pointer to the points to split.
+ * @param distance double The largest Euclidean distance at which two points are connected.
+ * @param clusters PointClusters* A pointer to a PointClusters structure that will contain the clusters in order of their first point.
+ *                                See clusterPoints() for their layout. This structure must be freed using freePointClusters().
+ * @return bool Returns true if the points were split; false if memory ran out.
+ *
+ */
+extern bool splitPoints(const PointArray *points, double distance, PointClusters *clusters);
+
+
+/** @brief Frees clusters filled by clusterPoints() or splitPoints(). The points of all clusters share one allocation,
+ *         so the PointArray of a single cluster must not be freed or grown on its own.
+ *
+ * @param clusters PointClusters* Pointer to the structure to be freed.
+ * @return void
+ *
+ */
+extern void freePointClusters(PointClusters *clusters);
+
+#endif // __cluster_h_
@@ -2,6 +2,7 @@
 #define __color_h_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <math.h>
 
 typedef struct rgb24_t
@@ -60,6 +61,17 @@ typedef struct ColorData_t
     };
 } ColorData;
 
+/** Samples of the LAB companding function over [0, LAB_CBRT_RANGE], interpolated linearly between steps. **/
+#define LAB_CBRT_STEPS 4096
+#define LAB_CBRT_RANGE 1.0625f
+
+typedef struct ColourTables_t
+{
+    float reciprocal[511];
+    float xyz[3][3][256];
+    float cbrt[LAB_CBRT_STEPS + 1];
+} ColourTables;
+
 
 
 /** @brief A function for converting the RGB pixel format to XYZ pixel format.
@@ -116,4 +128,78 @@ extern lab xyz_to_lab(xyz *px);
 extern xyz lab_to_xyz(lab *px);
 
 
-#endif // __color_h_
+/** @brief Retrieves the shared lookup tables used by rgb_to_hsl_lut() and rgb_to_lab_lut().
+ *         The tables are built on first use and are read-only afterwards, so they may be used from any thread.
+ *
+ * @return const ColourTables* A pointer to the shared tables.
+ *
+ */
+extern const ColourTables *getColourTables(void);
+
+
+/** @brief A table-driven equivalent of rgb_to_hsl() without any divisions.
+ *
+ * @param tables const ColourTables* The tables returned by getColourTables().
+ * @param px const rgb32* A pointer to the RGB pixel structure to be converted.
+ * @return hsl A pixel in the HSL format.
+ *
+ */
+static inline hsl rgb_to_hsl_lut(const ColourTables *tables, const rgb32 *px)
+{
+    hsl res;
+    int32_t r = px->r, g = px->g, b = px->b;
+    int32_t Max = r > g ? r : g;
+    int32_t Min = r < g ? r : g;
+    Max = Max > b ? Max : b;
+    Min = Min < b ? Min : b;
+    int32_t Delta = Max - Min;
+    int32_t Sum = Max + Min;
+
+    /** Arithmetic selects instead of branches. For grey pixels Delta is zero and reciprocal[0] is zero, so h and s come out as zero. **/
+    int32_t isR = Max == r;
+    int32_t isG = (Max == g) & !isR;
+    int32_t isB = !(isR | isG);
+    int32_t Num = isR * (g - b) + isG * (b - r) + isB * (r - g);
+    int32_t Offset = isR * (g < b) * 6 + isG * 2 + isB * 4;
+    int32_t Index = Sum - (Sum > 255) * (2 * Sum - 510);
+
+    res.h = (Num * tables->reciprocal[Delta] + Offset) * (100.0f / 6.0f);
+    res.s = Delta * tables->reciprocal[Index] * 100.0f;
+    res.l = Sum * (100.0f / 510.0f);
+    return res;
+}
+
+
+static inline float __lab_companding(const ColourTables *tables, float t)
+{
+    if (t <= 0.008856f)
+        return (t * 7.787f) + (16.0f / 116.0f);
+
+    float pos = t * (LAB_CBRT_STEPS / LAB_CBRT_RANGE);
+    int32_t index = (int32_t)pos;
+    if (index >= LAB_CBRT_STEPS)
+        index = LAB_CBRT_STEPS - 1;
+    return tables->cbrt[index] + (tables->cbrt[index + 1] - tables->cbrt[index]) * (pos - index);
+}
+
+
+/** @brief A table-driven equivalent of rgb_to_xyz() followed by xyz_to_lab() without any calls to pow().
+ *
+ * @param tables const ColourTables* The tables returned by getColourTables().
+ * @param px const rgb32* A pointer to the RGB pixel structure to be converted.
+ * @return lab A pixel in the LAB format.
+ *
+ */
+static inline lab rgb_to_lab_lut(const ColourTables *tables, const rgb32 *px)
+{
+    lab res;
+    float x = __lab_companding(tables, tables->xyz[0][0][px->r] + tables->xyz[0][1][px->g] + tables->xyz[0][2][px->b]);
+    float y = __lab_companding(tables, tables->xyz[1][0][px->r] + tables->xyz[1][1][px->g] + tables->xyz[1][2][px->b]);
+    float z = __lab_companding(tables, tables->xyz[2][0][px->r] + tables->xyz[2][1][px->g] + tables->xyz[2][2][px->b]);
+    res.l = ((y * 116.0f) - 16.0f);
+    res.a = ((x - y) * 500);
+    res.b = ((y - z) * 200);
+    return res;
+}
+
+#endif // __color_h_
\ No newline at end of file
@@ -0,0 +1,99 @@
+#ifndef __colourindex_h_
+#define __colourindex_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "finder.h"
+
+typedef struct ColourIndex_t ColourIndex;
+
+
+
+/** @brief Builds an index of an image's pixel positions grouped by exact colour. The alpha channel is ignored.
+ *
+ * @param image bitmap* Pointer to the image to index.
+ * @return ColourIndex* A pointer to the index or NULL on failure. Must be freed using freeColourIndex().
+ *
+ */
+extern ColourIndex *createColourIndex(bitmap *image);
+
+
+/** @brief Frees an index created by createColourIndex().
+ *
+ * @param index ColourIndex* Pointer to the index to be freed. May be NULL.
+ * @return void
+ *
+ */
+extern void freeColourIndex(ColourIndex *index);
+
+
+/** @brief Retrieves the colour index of the target image, building it once per frame.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target to use.
+ * @return const ColourIndex* A pointer to the index or NULL on failure. Valid until the frame changes.
+ *
+ */
+extern const ColourIndex *getColourIndex(CTSInfo *info);
+
+
+/** @brief Tells whether querying the index for a colour within an area is expected to be faster than scanning it.
+ *         A narrow area over a common colour needs a lookup on nearly every row and is cheaper to scan.
+ *
+ * @param index const ColourIndex* A pointer to the index to query.
+ * @param colour const rgb32* A pointer to the colour to query.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the index should answer the query; false if the area should be scanned.
+ *
+ */
+extern bool colourIndexPays(const ColourIndex *index, const rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Counts the pixels of exactly a colour within a specified area. Runs in time proportional to the rows of
+ *         the area that hold the colour, each costing a few binary searches, rather than to the area.
+ *
+ * @param index const ColourIndex* A pointer to the index to query.
+ * @param colour const rgb32* A pointer to the colour to count.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return uint32_t The amount of pixels of the colour within the area.
+ *
+ */
+extern uint32_t colourIndexCount(const ColourIndex *index, const rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds the first pixel in row-major order of exactly a colour within a specified area.
+ *
+ * @param index const ColourIndex* A pointer to the index to query.
+ * @param x int32_t* A pointer to an integer that will contain the x-coordinate of the first pixel found.
+ * @param y int32_t* A pointer to an integer that will contain the y-coordinate of the first pixel found.
+ * @param colour const rgb32* A pointer to the colour to find.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the colour is found within the area; false otherwise.
+ *
+ */
+extern bool colourIndexFind(const ColourIndex *index, int32_t *x, int32_t *y, const rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Appends every pixel of exactly a colour within a specified area to a PointArray in row-major order.
+ *
+ * @param index const ColourIndex* A pointer to the index to query.
+ * @param points PointArray* A pointer to an initialised PointArray structure the positions are appended to.
+ * @param colour const rgb32* A pointer to the colour to find.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if all positions could be appended; false if memory ran out.
+ *
+ */
+extern bool colourIndexFindAll(const ColourIndex *index, PointArray *points, const rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+#endif // __colourindex_h_
@@ -0,0 +1,48 @@
+#ifndef __correlation_h_
+#define __correlation_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "finder.h"
+
+typedef enum {CorrelateLuminance, CorrelateRGB} CorrelationMode;
+
+
+
+/** @brief Computes the normalised cross-correlation of an image with every position of a specified area.
+ *         Correlations are evaluated with fast Fourier transforms, so the cost depends on the size of the area
+ *         and not on the size of the image. Transparent pixels of the image are masked out.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and worker pool to use.
+ * @param imageToFind bitmap* A pointer to a bitmap structure representing the image to correlate. Its opaque pixels must not all be the same colour.
+ * @param mode CorrelationMode CorrelateLuminance correlates the luminance planes; CorrelateRGB correlates the three colour channels jointly.
+ * @param scores float* A pointer to an array of (x2 - x1 - width + 1) * (y2 - y1 - height + 1) floats that will contain the score of each
+ *                      position in row-major order, from -1 to 1. Positions whose pixels under the mask are uniform score 0.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the scores were computed; false if the image does not fit the area, has no contrast, or memory ran out.
+ *
+ */
+extern bool correlateImage(CTSInfo *info, bitmap* imageToFind, CorrelationMode mode, float *scores, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds the position of highest normalised cross-correlation of an image within a specified area.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and worker pool to use.
+ * @param imageToFind bitmap* A pointer to a bitmap structure representing the image to search for. Its opaque pixels must not all be the same colour.
+ * @param mode CorrelationMode CorrelateLuminance correlates the luminance planes; CorrelateRGB correlates the three colour channels jointly.
+ * @param x int32_t* A pointer to an integer that will contain the x-coordinate of the upper-left coordinate of the best position.
+ * @param y int32_t* A pointer to an integer that will contain the y-coordinate of the upper-left coordinate of the best position.
+ * @param score float* A pointer to a float that will contain the score of the best position, from -1 to 1. May be NULL.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if a position was scored; false otherwise.
+ *
+ */
+extern bool findImageCorrelation(CTSInfo *info, bitmap* imageToFind, CorrelationMode mode, int32_t *x, int32_t *y, float *score, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+#endif // __correlation_h_
@@ -26,6 +26,8 @@ typedef struct
     uint32_t count;
 } MDTM;
 
+typedef enum {DTMShapeSquare, DTMShapeCircle} DTMShape;
+
 typedef struct
 {
     int32_t x;
@@ -40,6 +42,7 @@ typedef struct
 {
     SDTMPoint main;
     SDTMPoint* points;
+    uint32_t count;
 } SDTM;
 
 extern void normalizeDTM(MDTM *dtm);
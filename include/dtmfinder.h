@@ -0,0 +1,199 @@
+#ifndef __dtmfinder_h_
+#define __dtmfinder_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dtm.h"
+#include "finder.h"
+
+/** A DTM laid out for matching. Sub-point attributes are held in parallel arrays, good points ahead of bad points,
+ *  each group ordered by how likely a point is to reject a position. Offsets are relative to the main point.
+ **/
+typedef struct CompiledDTM_t
+{
+    rgb32 colour;
+    uint16_t tol;
+    uint32_t count;
+    uint32_t goodCount;
+    const int32_t *x;
+    const int32_t *y;
+    const int32_t *size;
+    const rgb32 *colours;
+    const uint16_t *tols;
+    int32_t bounds[4];
+} CompiledDTM;
+
+
+
+/** @brief Compiles a DTM into the immutable form searched by findCompiledDTM() and friends, so that a DTM used
+ *         many times is only validated and ordered once.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions estimate how often each
+ *                      point's colour occurs. May be NULL or have no target, in which case points are ordered by area size.
+ * @param dtm const MDTM* A pointer to the DTM to compile. Its main point must not be bad.
+ * @return CompiledDTM* A pointer to the compiled DTM or NULL if the DTM is empty, its main point is bad, or memory ran out.
+ *                      Must be freed using freeCompiledDTM().
+ *
+ */
+extern CompiledDTM *compileDTM(CTSInfo *info, const MDTM *dtm);
+
+
+/** @brief Frees a DTM compiled by compileDTM().
+ *
+ * @param dtm CompiledDTM* Pointer to the compiled DTM to be freed. May be NULL.
+ * @return void
+ *
+ */
+extern void freeCompiledDTM(CompiledDTM *dtm);
+
+
+/** @brief Finds the first position in row-major order at which a compiled DTM matches within a specified area.
+ *         See findDTM() for how points are matched.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param dtm const CompiledDTM* A pointer to the compiled DTM to search for.
+ * @param x int32_t* A pointer to an integer that will contain the x-coordinate of the main point of the match.
+ * @param y int32_t* A pointer to an integer that will contain the y-coordinate of the main point of the match.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the DTM is found within the specified area; false otherwise.
+ *
+ */
+extern bool findCompiledDTM(CTSInfo *info, const CompiledDTM *dtm, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds every position at which a compiled DTM matches within a specified area. See findDTM() for how points are matched.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param dtm const CompiledDTM* A pointer to the compiled DTM to search for.
+ * @param points PointArray* A pointer to an empty PointArray structure that will contain the main point of each match in row-major order.
+ *                           This structure must be freed using freePointArray().
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the DTM is found within the specified area; false otherwise.
+ *
+ */
+extern bool findCompiledDTMs(CTSInfo *info, const CompiledDTM *dtm, PointArray *points, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds the first position in row-major order at which a compiled DTM matches at any of a range of angles.
+ *         See findDTMRotated() for how angles are stepped.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param dtm const CompiledDTM* A pointer to the compiled DTM to search for.
+ * @param x int32_t* A pointer to an integer that will contain the x-coordinate of the main point of the match.
+ * @param y int32_t* A pointer to an integer that will contain the y-coordinate of the main point of the match.
+ * @param angle double* A pointer to a double that will contain the first angle, in radians, at which the DTM matched. May be NULL.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @param startAngle double The first angle to try, in radians.
+ * @param endAngle double The last angle to try, in radians.
+ * @param step double The positive difference between consecutive angles, in radians.
+ * @return bool Returns true if the DTM is found within the specified area at any of the angles; false otherwise.
+ *
+ */
+extern bool findCompiledDTMRotated(CTSInfo *info, const CompiledDTM *dtm, int32_t *x, int32_t *y, double *angle, int32_t x1, int32_t y1, int32_t x2, int32_t y2, double startAngle, double endAngle, double step);
+
+
+/** @brief Finds the first position in row-major order at which a DTM matches within a specified area.
+ *
+ *         Point offsets are taken relative to the first (main) point, which must not be bad. The main point is compared
+ *         at the position itself; every other point matches if a pixel within size of its offset is similar to its colour
+ *         under the current CTS and its tolerance, and a bad point matches if no such pixel exists. Every offset must lie
+ *         within the area; areas of points are clipped to it. Colours are stored as in ColorData.
+ *         The DTM is compiled for every call; compile it once with compileDTM() when it is searched repeatedly.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param dtm const MDTM* A pointer to the DTM to search for.
+ * @param x int32_t* A pointer to an integer that will contain the x-coordinate of the main point of the match.
+ * @param y int32_t* A pointer to an integer that will contain the y-coordinate of the main point of the match.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the DTM is found within the specified area; false otherwise.
+ *
+ */
+extern bool findDTM(CTSInfo *info, const MDTM *dtm, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds every position at which a DTM matches within a specified area. See findDTM() for how points are matched.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param dtm const MDTM* A pointer to the DTM to search for.
+ * @param points PointArray* A pointer to an empty PointArray structure that will contain the main point of each match in row-major order.
+ *                           This structure must be freed using freePointArray().
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the DTM is found within the specified area; false otherwise.
+ *
+ */
+extern bool findDTMs(CTSInfo *info, const MDTM *dtm, PointArray *points, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds the first position in row-major order at which a DTM matches when rotated about its main point by any
+ *         angle from startAngle to endAngle in steps of step. See findDTM() for how points are matched.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param dtm const MDTM* A pointer to the DTM to search for.
+ * @param x int32_t* A pointer to an integer that will contain the x-coordinate of the main point of the match.
+ * @param y int32_t* A pointer to an integer that will contain the y-coordinate of the main point of the match.
+ * @param angle double* A pointer to a double that will contain the first angle, in radians, at which the DTM matched. May be NULL.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @param startAngle double The first angle to try, in radians. Positive angles rotate clockwise on screen.
+ * @param endAngle double The last angle to try, in radians.
+ * @param step double The positive difference between consecutive angles, in radians.
+ * @return bool Returns true if the DTM is found within the specified area at any of the angles; false otherwise.
+ *
+ */
+extern bool findDTMRotated(CTSInfo *info, const MDTM *dtm, int32_t *x, int32_t *y, double *angle, int32_t x1, int32_t y1, int32_t x2, int32_t y2, double startAngle, double endAngle, double step);
+
+
+/** @brief Finds the first position in row-major order at which a shaped DTM matches within a specified area.
+ *
+ *         Offsets are taken relative to the main point. Every point, the main point included, matches if a pixel within
+ *         its area is similar to its colour under the current CTS and its tolerance. The area of a point is a square
+ *         (DTMShapeSquare) or a disc (DTMShapeCircle) of radius size around its offset; other shapes are treated as
+ *         squares. Every offset must lie within the area to search; areas are clipped to it. Colours are stored as in ColorData.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param dtm const SDTM* A pointer to the DTM to search for.
+ * @param x int32_t* A pointer to an integer that will contain the x-coordinate of the main point of the match.
+ * @param y int32_t* A pointer to an integer that will contain the y-coordinate of the main point of the match.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the DTM is found within the specified area; false otherwise.
+ *
+ */
+extern bool findSDTM(CTSInfo *info, const SDTM *dtm, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds every position at which a shaped DTM matches within a specified area. See findSDTM() for how points are matched.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param dtm const SDTM* A pointer to the DTM to search for.
+ * @param points PointArray* A pointer to an empty PointArray structure that will contain the main point of each match in row-major order.
+ *                           This structure must be freed using freePointArray().
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the DTM is found within the specified area; false otherwise.
+ *
+ */
+extern bool findSDTMs(CTSInfo *info, const SDTM *dtm, PointArray *points, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+#endif // __dtmfinder_h_
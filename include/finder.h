@@ -4,6 +4,26 @@
 #include <stdint.h>
 #include "bitmap.h"
 #include "color.h"
+#include "points.h"
+#include "target.h"
+#include "template.h"
+#include "threadpool.h"
+
+typedef struct CTSKernels_t CTSKernels;
+typedef struct ColourMatcher_t ColourMatcher;
+typedef struct FrameCache_t FrameCache;
+typedef struct FinderExecutor_t FinderExecutor;
+
+/** Frame pixels owned elsewhere, such as the buffer behind a Target, read in place. Pixels are in ColorData (BGR)
+ *  order and rows are stride pixels apart.
+ **/
+typedef struct TargetView_t
+{
+    const ColorData *data;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+} TargetView;
 
 typedef struct CTSInfo_t
 {
@@ -12,43 +32,76 @@ typedef struct CTSInfo_t
     bitmap *targetImage;
 
     bool (*ctsFuncPtr)(void *this_ptr, rgb32 *first, rgb32 *second);
+    const CTSKernels *kernels;
+    ThreadPool *pool;
+    bool countFirst; //findColours* count the matches before filling so the result is allocated exactly once.
+    FrameCache *cache; //Data derived from targetImage, rebuilt when the target or its frame changes. See framecache.h.
+    uint64_t frame; //Counts the frames of the target. Bumped by setTargetImage(), setTargetView() and updateFrameDiff().
+    bool colourIndex; //Exact (CTS -1) colour queries are answered from a per-frame index of positions by colour. See colourindex.h.
+    bool tileBounds; //CTS -1 to 1 colour scans skip tiles of the target whose colour bounds rule out a match. See tilebounds.h.
+    bool windowSums; //CTS -1 to 1 image searches skip positions whose window sums of the target rule out a match. See integral.h.
+    TargetView targetView; //While data is set, searches read this view instead of targetImage. See setTargetView().
+    const bool *cancel; //Once this points to true, searches stop at their next row of tiles. See searchCancelled().
 
 } CTSInfo;
 
-typedef struct Point_t
+typedef struct ColourQuery_t
+{
+    rgb32 colour;
+    uint16_t tol;
+    int16_t CTSNum;
+} ColourQuery;
+
+typedef enum {ColourScanCount, ColourScanFind, ColourScanFindAll} ColourScanKind;
+
+typedef struct ColourScan_t
 {
-    int32_t x;
-    int32_t y;
-} Point;
+    ColourQuery query;
+    ColourScanKind kind;
+    int32_t x1, y1, x2, y2;
+} ColourScan;
 
-typedef struct PointArray_t
+typedef struct ColourScanResult_t
 {
-    Point* p;
-    size_t size;
-} PointArray;
+    uint32_t count;
+    int32_t x, y;
+    PointArray points;
+} ColourScanResult;
+
+typedef enum {ScoreSSD, ScoreSAD} ImageScore;
+
+typedef struct ImageMatch_t
+{
+    int32_t x, y;
+    uint64_t score;
+} ImageMatch;
 
 typedef struct Finder_t
 {
     CTSInfo info;
+    ThreadPool *pool;
+    FinderExecutor *executor;
 } Finder;
 
 
-/** @brief Initialises a point array. All values are set to default. No memory is allocated by this function.
+/** @brief Initialises a finder with default CTS settings and a worker pool that large searches are split across.
  *
- * @param pa PointArray* Pointer to the PointArray structure to be initialised.
- * @return void
+ * @param finder Finder* Pointer to the Finder structure to be initialised.
+ * @param threads uint32_t The amount of threads to search with. Zero uses one per online processor; one searches on the calling thread only.
+ * @return bool Returns true if the finder and its pool were created; false otherwise.
  *
  */
-extern void initPointArray(PointArray* pa);
+extern bool initFinder(Finder *finder, uint32_t threads);
 
 
-/** @brief Frees a PointArray and nullifies all data-members.
+/** @brief Cancels the finder's unfinished asynchronous tasks, stops its executor and worker pool and nullifies its members.
+ *         The target image is not freed, nor are the tasks, which can still be waited on and freed.
  *
- * @param pa PointArray* Pointer to the structure to be freed. free() is called on the data-member p.
- * @return extern void
+ * @param finder Finder* Pointer to the Finder structure to be freed.
+ * @return void
  *
  */
-extern void freePointArray(PointArray* pa);
+extern void freeFinder(Finder *finder);
 
 
 /** @brief Initialises all members of a CTSInfo structure to their default values.
@@ -60,7 +113,16 @@ extern void freePointArray(PointArray* pa);
 extern void defaultCTS(CTSInfo *info);
 
 
-/** @brief Sets the CTSInfo structure's comparison function pointer.
+/** @brief Frees the data a CTSInfo structure derived from its target images. The target image is not freed.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose caches to free.
+ * @return void
+ *
+ */
+extern void freeCTS(CTSInfo *info);
+
+
+/** @brief Sets the CTSInfo structure's comparison function pointer and the scan kernels specialised for that comparison.
  *
  * @param info CTSInfo* A pointer to the CTSInfo structure whose pointer to set.
  * @param CTSNum int16_t A CTS value from -1 to 3 inclusive.
@@ -70,6 +132,85 @@ extern void defaultCTS(CTSInfo *info);
 extern void setCTS(CTSInfo *info, int16_t CTSNum);
 
 
+/** @brief Sets the image searches read and starts a new frame, so data derived from the previous frame, such as the
+ *         colour index or tile bounds, is rebuilt on first use. Call it for every frame, also when a frame was written
+ *         into the same image as the one before.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target to set.
+ * @param image bitmap* A pointer to the frame to search. Must stay valid while it is the target.
+ * @return void
+ *
+ */
+extern void setTargetImage(CTSInfo *info, bitmap *image);
+
+
+/** @brief Lets searches read a Target's pixels in place instead of a copy in targetImage. The CTS -1 to 1 scans run on
+ *         the BGR pixels as they are; CTS 2 and 3 swap each pixel as it is read. Colour, image, template and DTM
+ *         searches all read the view. Colour indexes, tile bounds, window sums and template pyramids are only built
+ *         from targetImage, so searches do without them while a view is set. Starts a new frame as setTargetImage() does.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose view to set.
+ * @param data TargetData The pixels returned by getTargetData(). They must stay valid while the view is set.
+ * @param width uint32_t The width that was passed to getTargetData().
+ * @param height uint32_t The height that was passed to getTargetData().
+ * @return void
+ *
+ */
+extern void setTargetView(CTSInfo *info, TargetData data, uint32_t width, uint32_t height);
+
+
+/** @brief Makes searches read targetImage again.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose view to clear.
+ * @return void
+ *
+ */
+extern void clearTargetView(CTSInfo *info);
+
+
+/** @brief Retrieves the size of the frame searches read: the target view while one is set, targetImage otherwise.
+ *
+ * @param info const CTSInfo* A pointer to the CTSInfo structure whose frame to measure.
+ * @param width uint32_t* A pointer to an integer that will contain the width of the frame.
+ * @param height uint32_t* A pointer to an integer that will contain the height of the frame.
+ * @return void
+ *
+ */
+static inline void getFrameSize(const CTSInfo *info, uint32_t *width, uint32_t *height)
+{
+    *width = info->targetView.data ? info->targetView.width : info->targetImage ? info->targetImage->width : 0;
+    *height = info->targetView.data ? info->targetView.height : info->targetImage ? info->targetImage->height : 0;
+}
+
+
+/** @brief Retrieves a row of the frame searches read. Rows of a target view hold ColorData (BGR) pixels.
+ *
+ * @param info const CTSInfo* A pointer to the CTSInfo structure whose frame to read.
+ * @param y int32_t The row to retrieve.
+ * @return const rgb32* A pointer to the first pixel of the row.
+ *
+ */
+static inline const rgb32 *getFrameRow(const CTSInfo *info, int32_t y)
+{
+    if (info->targetView.data)
+        return (const rgb32 *)&info->targetView.data[(size_t)y * info->targetView.stride];
+    return &info->targetImage->pixels[(size_t)y * info->targetImage->width];
+}
+
+
+/** @brief Tells whether a search was asked to stop through the CTSInfo's cancel flag. Scans check it once per row of
+ *         tiles (TILE_BOUNDS_SIZE rows) and give up when it is set, leaving their results incomplete.
+ *
+ * @param info const CTSInfo* A pointer to the CTSInfo structure a search runs on.
+ * @return bool Returns true if the CTSInfo has a cancel flag and it is set.
+ *
+ */
+static inline bool searchCancelled(const CTSInfo *info)
+{
+    return info->cancel && __atomic_load_n(info->cancel, __ATOMIC_RELAXED);
+}
+
+
 /** @brief Compares two pixels for similarity.
  *
  * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
@@ -82,6 +223,45 @@ extern void setCTS(CTSInfo *info, int16_t CTSNum);
 extern bool similarColours(CTSInfo *info, rgb32 *first, rgb32 *second, uint16_t tolerance);
 
 
+/** @brief Prepares colours for repeated tests against small areas of the frame under the CTS set at the time, so each
+ *         test runs the comparison without converting the colour again. Suited to checks made at many positions, such
+ *         as the sub-points of a DTM.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose comparison to prepare for.
+ * @param colours const rgb32* An array of the colours to prepare.
+ * @param tolerances const uint16_t* An array holding the tolerance of each colour.
+ * @param count uint32_t The amount of colours.
+ * @return ColourMatcher* A pointer to the prepared colours or NULL if memory ran out. Must be freed using freeColourMatcher().
+ *
+ */
+extern ColourMatcher *createColourMatcher(CTSInfo *info, const rgb32 *colours, const uint16_t *tolerances, uint32_t count);
+
+
+/** @brief Tests whether any pixel of a specified area of the frame is similar to a prepared colour. The area must lie
+ *         within the frame.
+ *
+ * @param info const CTSInfo* A pointer to the CTSInfo structure whose frame to read.
+ * @param matcher const ColourMatcher* A pointer to the prepared colours.
+ * @param index uint32_t The index of the colour to test.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area.
+ * @return bool Returns true if a pixel of the area matches the colour; false otherwise.
+ *
+ */
+extern bool matchColourIn(const CTSInfo *info, const ColourMatcher *matcher, uint32_t index, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Frees colours prepared by createColourMatcher().
+ *
+ * @param matcher ColourMatcher* A pointer to the prepared colours. May be NULL.
+ * @return void
+ *
+ */
+extern void freeColourMatcher(ColourMatcher *matcher);
+
+
 /** @brief Counts the colours within a specified area without a tolerance threshold.
  *
  * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
@@ -179,6 +359,137 @@ extern bool findColours(CTSInfo *info, PointArray *points, rgb32* colour, int32_
 extern bool findColoursTolerance(CTSInfo *info, PointArray *points, rgb32* colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
 
 
+/** @brief Finds a colour within a specified area without a tolerance threshold, reusing the memory of a caller-owned PointArray.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param points PointArray* A pointer to a PointArray structure whose contents are replaced by the location of each colour found.
+ *                           Its memory is kept and only grown when needed, so the same structure can be passed on every frame.
+ *                           This structure must be initialised using initPointArray() and eventually freed using freePointArray().
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to find.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the colour is found within the specified area; false otherwise.
+ *
+ */
+extern bool findColoursInto(CTSInfo *info, PointArray *points, rgb32* colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds a colour within a specified area with a tolerance threshold, reusing the memory of a caller-owned PointArray.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param points PointArray* A pointer to a PointArray structure whose contents are replaced by the location of each colour found.
+ *                           Its memory is kept and only grown when needed, so the same structure can be passed on every frame.
+ *                           This structure must be initialised using initPointArray() and eventually freed using freePointArray().
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to find.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @return bool Returns true if the colour is found within the specified area and lies within the tolerance threshold; false otherwise.
+ *
+ */
+extern bool findColoursToleranceInto(CTSInfo *info, PointArray *points, rgb32* colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+
+
+/** @brief Marks every pixel of a specified area that is similar to a colour, one bit per pixel. Runs on the calling thread.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param bits uint32_t* A pointer to the words of the first row. Bit I of a row stands for column x1 + I; the words of a row are overwritten.
+ * @param words uint32_t The distance between rows in words. Must be at least (x2 - x1 + 31) / 32.
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to match.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @return void
+ *
+ */
+extern void maskColoursTolerance(CTSInfo *info, uint32_t *bits, uint32_t words, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+
+
+/** @brief Finds the match of a colour closest to an origin, searching outwards in square rings, without a tolerance threshold.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param x int32_t* A pointer to an integer that will contain the x-coordinate of the closest colour found.
+ * @param y int32_t* A pointer to an integer that will contain the y-coordinate of the closest colour found.
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to find.
+ * @param originX int32_t The x-coordinate to search outwards from. May lie outside the area.
+ * @param originY int32_t The y-coordinate to search outwards from. May lie outside the area.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the colour is found within the specified area; false otherwise.
+ *
+ */
+extern bool findColourSpiral(CTSInfo *info, int32_t *x, int32_t *y, rgb32* colour, int32_t originX, int32_t originY, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds the match of a colour closest to an origin, searching outwards in square rings, with a tolerance threshold.
+ *         The search stops once no unscanned ring can hold a closer match, so matches near the origin are found
+ *         without scanning the rest of the area.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param x int32_t* A pointer to an integer that will contain the x-coordinate of the closest colour found. Ties go to the first in row-major order.
+ * @param y int32_t* A pointer to an integer that will contain the y-coordinate of the closest colour found.
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to find.
+ * @param originX int32_t The x-coordinate to search outwards from. May lie outside the area.
+ * @param originY int32_t The y-coordinate to search outwards from. May lie outside the area.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @return bool Returns true if the colour is found within the specified area and lies within the tolerance threshold; false otherwise.
+ *
+ */
+extern bool findColourSpiralTolerance(CTSInfo *info, int32_t *x, int32_t *y, rgb32* colour, int32_t originX, int32_t originY, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+
+
+/** @brief Finds every match of a colour within a specified area, sorted by distance from an origin, without a tolerance threshold.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param points PointArray* A pointer to a PointArray structure that will contain the location of each colour found, closest first.
+ *                           This structure's members must be set to default using initPointArray().
+ *                           This structure must be freed using freePointArray().
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to find.
+ * @param originX int32_t The x-coordinate distances are measured from.
+ * @param originY int32_t The y-coordinate distances are measured from.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the colour is found within the specified area; false otherwise.
+ *
+ */
+extern bool findColoursSpiral(CTSInfo *info, PointArray *points, rgb32* colour, int32_t originX, int32_t originY, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds every match of a colour within a specified area, sorted by distance from an origin, with a tolerance threshold.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param points PointArray* A pointer to a PointArray structure that will contain the location of each colour found, closest first.
+ *                           Equally distant points keep row-major order.
+ *                           This structure's members must be set to default using initPointArray().
+ *                           This structure must be freed using freePointArray().
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to find.
+ * @param originX int32_t The x-coordinate distances are measured from.
+ * @param originY int32_t The y-coordinate distances are measured from.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @return bool Returns true if the colour is found within the specified area and lies within the tolerance threshold; false otherwise.
+ *
+ */
+extern bool findColoursSpiralTolerance(CTSInfo *info, PointArray *points, rgb32* colour, int32_t originX, int32_t originY, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+
+
 /** @brief Finds an image within the target area without a tolerance threshold.
  *
  * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
@@ -223,4 +534,128 @@ extern bool findImageIn(CTSInfo *info, bitmap* imageToFind, int32_t *x, int32_t
  */
 extern bool findImageToleranceIn(CTSInfo *info, bitmap* imageToFind, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
 
+
+/** @brief Finds a prepared template within a specified area without a tolerance threshold.
+ *         Returns the same position as findImageIn() but rejects most positions on a downsampled copy of the target.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param tpl Template* A pointer to a template created from the image to search for using createTemplate().
+ * @param x int32_t* A pointer to an integer that will contain the x-coordinate of the upper-left coordinate of the image found.
+ * @param y int32_t* A pointer to an integer that will contain the y-coordinate of the upper-left coordinate of the image found.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the image is found within the specified area; false otherwise.
+ *
+ */
+extern bool findTemplateIn(CTSInfo *info, Template *tpl, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds a prepared template within a specified area with a tolerance threshold.
+ *         Returns the same position as findImageToleranceIn(). For CTS -1, 0 and 1 candidates are first tested on
+ *         block sums of the target, which are built once per frame, and only survivors are compared pixel by pixel.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target and comparator functions to use.
+ * @param tpl Template* A pointer to a template created from the image to search for using createTemplate().
+ * @param x int32_t* A pointer to an integer that will contain the x-coordinate of the upper-left coordinate of the image found.
+ * @param y int32_t* A pointer to an integer that will contain the y-coordinate of the upper-left coordinate of the image found.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @return bool Returns true if the image is found within the specified area and lies within the specified threshold; false otherwise.
+ *
+ */
+extern bool findTemplateToleranceIn(CTSInfo *info, Template *tpl, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+
+
+/** @brief Finds the position where an image differs least from the target.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target to use.
+ * @param imageToFind bitmap* A pointer to a bitmap structure representing the image to search the target area for. Transparent pixels are ignored.
+ * @param metric ImageScore ScoreSSD sums the squared and ScoreSAD the absolute per-channel differences of all opaque pixels.
+ * @param best ImageMatch* A pointer to a structure that will contain the upper-left coordinate and score of the best position.
+ *                         Ties go to the first position in row-major order.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if the image fits within the specified area; false otherwise.
+ *
+ */
+extern bool findImageBest(CTSInfo *info, bitmap* imageToFind, ImageScore metric, ImageMatch *best, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds the K positions where an image differs least from the target.
+ *         A position is abandoned as soon as its partial score can no longer beat the current K-th best.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target to use.
+ * @param imageToFind bitmap* A pointer to a bitmap structure representing the image to search the target area for. Transparent pixels are ignored.
+ * @param metric ImageScore ScoreSSD sums the squared and ScoreSAD the absolute per-channel differences of all opaque pixels.
+ * @param matches ImageMatch* A pointer to an array of k structures that will contain the best positions, lowest score first.
+ *                            Ties go to the first position in row-major order.
+ * @param k uint32_t The amount of positions to keep.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return uint32_t Returns the amount of positions stored in matches. Less than k if the area holds fewer positions.
+ *
+ */
+extern uint32_t findImagesTopK(CTSInfo *info, bitmap* imageToFind, ImageScore metric, ImageMatch *matches, uint32_t k, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Counts several colours within a specified area in a single pass over its pixels.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target to use. Each query uses its own CTS and tolerance.
+ * @param queries const ColourQuery* A pointer to an array of queries, each holding a colour, a tolerance and a CTS value from -1 to 3.
+ * @param count uint32_t The amount of queries.
+ * @param counts uint32_t* A pointer to an array of count integers that will contain the amount of matches of each query.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if any of the colours is found within the specified area; false otherwise.
+ *
+ */
+extern bool countColoursMulti(CTSInfo *info, const ColourQuery *queries, uint32_t count, uint32_t *counts, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Finds several colours within a specified area in a single pass over its pixels.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target to use. Each query uses its own CTS and tolerance.
+ * @param queries const ColourQuery* A pointer to an array of queries, each holding a colour, a tolerance and a CTS value from -1 to 3.
+ * @param count uint32_t The amount of queries.
+ * @param results PointArray* A pointer to an array of count PointArray structures. Each one's contents are replaced by the location of every
+ *                            match of the corresponding query in row-major order. Their memory is kept so they can be reused across frames.
+ *                            These structures must be initialised using initPointArray() and eventually freed using freePointArray().
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return bool Returns true if any of the colours is found within the specified area; false otherwise.
+ *
+ */
+extern bool findColoursMulti(CTSInfo *info, const ColourQuery *queries, uint32_t count, PointArray *results, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Runs several colour scans, each over its own area, in a single pass over a range of rows. Every row is fetched
+ *         once and scanned by all scans whose area covers it. Runs on the calling thread, so separate ranges of rows can be
+ *         handed to separate threads, each with its own results.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target to use. Each scan uses its own CTS and tolerance.
+ * @param scans const ColourScan* A pointer to an array of scans, each holding a query, what to collect and the area to search.
+ * @param count uint32_t The amount of scans.
+ * @param results ColourScanResult* A pointer to an array of count results. ColourScanCount adds the amount of matches to count;
+ *                                  ColourScanFind sets x and y to the first match in row-major order unless x is already
+ *                                  other than -1; ColourScanFindAll appends every match to an initialised points array.
+ * @param y1 int32_t The first row to scan.
+ * @param y2 int32_t One past the last row to scan.
+ * @return bool Returns true if all scans ran; false if memory ran out.
+ *
+ */
+extern bool scanColourRows(CTSInfo *info, const ColourScan *scans, uint32_t count, ColourScanResult *results, int32_t y1, int32_t y2);
+
 #endif // __finder_h_
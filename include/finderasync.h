@@ -0,0 +1,151 @@
+#ifndef __finderasync_h_
+#define __finderasync_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dtmfinder.h"
+#include "finder.h"
+
+typedef enum {FinderTaskQueued, FinderTaskRunning, FinderTaskDone, FinderTaskCancelled} FinderTaskState;
+
+/** The result of an asynchronous search once its task is done. found is set by every search; count by
+ *  countColourToleranceAsync(); x and y by the searches for a single position (-1 when nothing is found); points by
+ *  findColoursToleranceAsync().
+ **/
+typedef struct FinderTaskResult_t
+{
+    bool found;
+    uint32_t count;
+    int32_t x, y;
+    PointArray points;
+} FinderTaskResult;
+
+typedef struct FinderTask_t FinderTask;
+
+
+
+/** @brief Starts counting a colour within a specified area as countColourTolerance() does, on the finder's executor.
+ *         Tasks of a finder run one at a time in the order they were started. Each runs on a copy of the finder's
+ *         CTSInfo taken now, so later changes to its CTS or target do not affect it; the target image or view itself
+ *         must stay valid until the task finished. Data derived from the frame, such as tile bounds or the colour
+ *         index, is built in a cache of the task's own and freed with it. Its search spreads across the finder's
+ *         worker pool unless a search on the calling thread holds the pool, in which case either runs on its own thread.
+ *
+ * @param finder Finder* A pointer to an initialised finder.
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to count.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @return FinderTask* A handle to the task or NULL if the executor could not be started or memory ran out.
+ *                     Must be freed using freeFinderTask().
+ *
+ */
+extern FinderTask *countColourToleranceAsync(Finder *finder, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+
+
+/** @brief Starts finding the first position of a colour as findColourTolerance() does, on the finder's executor.
+ *         See countColourToleranceAsync() for the parameters and how tasks run.
+ *
+ * @return FinderTask* A handle to the task or NULL if the executor could not be started or memory ran out.
+ *
+ */
+extern FinderTask *findColourToleranceAsync(Finder *finder, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+
+
+/** @brief Starts finding every position of a colour as findColoursTolerance() does, on the finder's executor.
+ *         See countColourToleranceAsync() for the parameters and how tasks run.
+ *
+ * @return FinderTask* A handle to the task or NULL if the executor could not be started or memory ran out.
+ *
+ */
+extern FinderTask *findColoursToleranceAsync(Finder *finder, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+
+
+/** @brief Starts finding an image as findImageToleranceIn() does, on the finder's executor.
+ *         See countColourToleranceAsync() for how tasks run.
+ *
+ * @param finder Finder* A pointer to an initialised finder.
+ * @param image bitmap* A pointer to the image to find. Must stay valid until the task finished.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @return FinderTask* A handle to the task or NULL if the executor could not be started or memory ran out.
+ *
+ */
+extern FinderTask *findImageToleranceInAsync(Finder *finder, bitmap *image, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+
+
+/** @brief Starts finding a compiled DTM as findCompiledDTM() does, on the finder's executor.
+ *         See countColourToleranceAsync() for how tasks run.
+ *
+ * @param finder Finder* A pointer to an initialised finder.
+ * @param dtm const CompiledDTM* A pointer to the compiled DTM to find. Must stay valid until the task finished.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return FinderTask* A handle to the task or NULL if the executor could not be started or memory ran out.
+ *
+ */
+extern FinderTask *findCompiledDTMAsync(Finder *finder, const CompiledDTM *dtm, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Retrieves the state of a task without blocking.
+ *
+ * @param task FinderTask* A pointer to the task.
+ * @return FinderTaskState The current state of the task.
+ *
+ */
+extern FinderTaskState pollFinderTask(FinderTask *task);
+
+
+/** @brief Blocks until a task is done or cancelled.
+ *
+ * @param task FinderTask* A pointer to the task.
+ * @return FinderTaskState FinderTaskDone or FinderTaskCancelled.
+ *
+ */
+extern FinderTaskState waitFinderTask(FinderTask *task);
+
+
+/** @brief Asks a task to stop. A queued task is dropped at once; a running search stops at its next row of tiles.
+ *         The task then ends as cancelled, unless it already finished. Does not block.
+ *
+ * @param task FinderTask* A pointer to the task.
+ * @return void
+ *
+ */
+extern void cancelFinderTask(FinderTask *task);
+
+
+/** @brief Retrieves the result of a finished task.
+ *
+ * @param task FinderTask* A pointer to the task.
+ * @return const FinderTaskResult* A pointer to the result, valid until the task is freed, or NULL unless the task is done.
+ *
+ */
+extern const FinderTaskResult *getFinderTaskResult(FinderTask *task);
+
+
+/** @brief Cancels a task if it has not finished, waits for it to stop and frees it together with its result.
+ *
+ * @param task FinderTask* A pointer to the task. May be NULL.
+ * @return void
+ *
+ */
+extern void freeFinderTask(FinderTask *task);
+
+
+/** @brief Cancels every unfinished task of a finder and stops its executor. Called by freeFinder().
+ *
+ * @param finder Finder* A pointer to the finder whose executor to stop.
+ * @return void
+ *
+ */
+extern void freeFinderExecutor(Finder *finder);
+
+#endif // __finderasync_h_
@@ -0,0 +1,144 @@
+#ifndef __finderbatch_h_
+#define __finderbatch_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dtmfinder.h"
+#include "finder.h"
+
+typedef enum {BatchCountColour, BatchFindColour, BatchFindColours, BatchFindImage, BatchFindDTM} BatchQueryKind;
+
+/** A query of a FinderBatch and, once the batch has run, its result. found is set by every kind; count by
+ *  BatchCountColour; x and y by the kinds that find a single position (-1 when nothing is found); points by
+ *  BatchFindColours.
+ **/
+typedef struct BatchQuery_t
+{
+    BatchQueryKind kind;
+    int16_t CTSNum;
+    uint16_t tolerance;
+    int32_t x1, y1, x2, y2;
+    rgb32 colour;
+    bitmap *image;
+    const CompiledDTM *dtm;
+
+    bool found;
+    uint32_t count;
+    int32_t x, y;
+    PointArray points;
+} BatchQuery;
+
+typedef struct FinderBatch_t
+{
+    BatchQuery *queries;
+    uint32_t count;
+    uint32_t capacity;
+} FinderBatch;
+
+
+
+/** @brief Initialises an empty batch. No memory is allocated by this function.
+ *
+ * @param batch FinderBatch* Pointer to the FinderBatch structure to be initialised.
+ * @return void
+ *
+ */
+extern void initFinderBatch(FinderBatch *batch);
+
+
+/** @brief Frees the memory of a batch, the points of its queries included, and empties it.
+ *
+ * @param batch FinderBatch* Pointer to the batch to be freed.
+ * @return void
+ *
+ */
+extern void freeFinderBatch(FinderBatch *batch);
+
+
+/** @brief Removes every query from a batch. Memory is kept, points arrays included, so the same batch can be refilled every frame.
+ *
+ * @param batch FinderBatch* Pointer to the batch to be emptied.
+ * @return void
+ *
+ */
+extern void clearFinderBatch(FinderBatch *batch);
+
+
+/** @brief Adds a query that counts a colour within a specified area.
+ *
+ * @param batch FinderBatch* A pointer to an initialised batch.
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to count.
+ * @param CTSNum int16_t The CTS value from -1 to 3 to compare with.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return int32_t The index of the query in batch->queries or -1 if memory ran out.
+ *
+ */
+extern int32_t addCountColourQuery(FinderBatch *batch, rgb32 *colour, int16_t CTSNum, uint16_t tolerance, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Adds a query that finds the first position of a colour in row-major order within a specified area.
+ *         See addCountColourQuery() for the parameters.
+ *
+ * @return int32_t The index of the query in batch->queries or -1 if memory ran out.
+ *
+ */
+extern int32_t addFindColourQuery(FinderBatch *batch, rgb32 *colour, int16_t CTSNum, uint16_t tolerance, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Adds a query that finds every position of a colour in row-major order within a specified area.
+ *         See addCountColourQuery() for the parameters.
+ *
+ * @return int32_t The index of the query in batch->queries or -1 if memory ran out.
+ *
+ */
+extern int32_t addFindColoursQuery(FinderBatch *batch, rgb32 *colour, int16_t CTSNum, uint16_t tolerance, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Adds a query that finds an image within a specified area as findImageToleranceIn() does.
+ *
+ * @param batch FinderBatch* A pointer to an initialised batch.
+ * @param image bitmap* A pointer to the image to find. Must stay valid until the batch has run.
+ * @param CTSNum int16_t The CTS value from -1 to 3 to compare with.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return int32_t The index of the query in batch->queries or -1 if memory ran out.
+ *
+ */
+extern int32_t addFindImageQuery(FinderBatch *batch, bitmap *image, int16_t CTSNum, uint16_t tolerance, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Adds a query that finds a compiled DTM within a specified area as findCompiledDTM() does.
+ *
+ * @param batch FinderBatch* A pointer to an initialised batch.
+ * @param dtm const CompiledDTM* A pointer to the compiled DTM to find. Must stay valid until the batch has run.
+ * @param CTSNum int16_t The CTS value from -1 to 3 to compare with.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @return int32_t The index of the query in batch->queries or -1 if memory ran out.
+ *
+ */
+extern int32_t addFindDTMQuery(FinderBatch *batch, const CompiledDTM *dtm, int16_t CTSNum, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Runs every query of a batch against the finder's current frame in one scheduled pass over its worker pool.
+ *         Colour queries are fused: rows are cut into bands, and each band fetches a row once for every colour query
+ *         whose area covers it. Image and DTM queries run as tasks of their own in the same pass. Results are stored
+ *         in the queries and match those of the corresponding single calls.
+ *
+ * @param finder Finder* A pointer to the finder whose frame and worker pool to use. Its CTS settings are left unchanged.
+ * @param batch FinderBatch* A pointer to the batch to run.
+ * @return bool Returns true if every query ran; false if memory ran out, in which case no result is valid.
+ *
+ */
+extern bool runFinderBatch(Finder *finder, FinderBatch *batch);
+
+#endif // __finderbatch_h_
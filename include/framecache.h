@@ -0,0 +1,55 @@
+#ifndef __framecache_h_
+#define __framecache_h_
+
+#include "finder.h"
+
+typedef enum {FramePyramidData, FrameIntegralData, FrameColourIndexData, FrameTileBoundsData, FrameDataKinds} FrameDataKind;
+
+typedef void *(*buildFrameDataT)(CTSInfo *info);
+typedef void (*freeFrameDataT)(void *data);
+
+
+
+/** @brief Retrieves data derived from the target image, building it on first use.
+ *         Derived data is kept until the target's pixel buffer or dimensions change, a new frame is started through
+ *         setTargetImage(), setTargetView() or updateFrameDiff(), or invalidateFrameCache() is called.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target the data is derived from.
+ * @param kind FrameDataKind The kind of data to retrieve. Each kind is built at most once per frame.
+ * @param build buildFrameDataT A function that builds the data from the target. Returns NULL on failure.
+ * @param release freeFrameDataT A function that frees data returned by build.
+ * @return void* A pointer to the data or NULL if it could not be built. Valid until the frame changes.
+ *
+ */
+extern void *getFrameData(CTSInfo *info, FrameDataKind kind, buildFrameDataT build, freeFrameDataT release);
+
+
+/** @brief Creates the frame cache of a CTSInfo structure unless it has one, so that copies of the structure made
+ *         afterwards share it and build each kind of data once between them.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose cache to create.
+ * @return bool Returns true if the structure has a cache; false if memory ran out.
+ *
+ */
+extern bool createFrameCache(CTSInfo *info);
+
+
+/** @brief Discards all data derived from the target image. Only needed after modifying the target's pixels in place
+ *         without starting a new frame.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose derived data to discard.
+ * @return void
+ *
+ */
+extern void invalidateFrameCache(CTSInfo *info);
+
+
+/** @brief Discards all data derived from the target image and frees the cache itself.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose cache to free.
+ * @return void
+ *
+ */
+extern void freeFrameCache(CTSInfo *info);
+
+#endif // __framecache_h_
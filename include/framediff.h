@@ -0,0 +1,123 @@
+#ifndef __framediff_h_
+#define __framediff_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "finder.h"
+#include "matchmask.h"
+
+#define FRAME_DIFF_TILE 32
+
+/** The tiles of FRAME_DIFF_TILE x FRAME_DIFF_TILE pixels whose colours changed between the last two frames passed to
+ *  updateFrameDiff(). dirty holds one flag per tile in row-major order; frame counts the updates so far.
+ **/
+typedef struct FrameDiff_t
+{
+    uint32_t width, height;
+    uint32_t tilesX, tilesY;
+    uint8_t *dirty;
+    uint32_t dirtyCount;
+    uint64_t frame;
+    bool bgr;
+    rgb32 *previous;
+} FrameDiff;
+
+/** The matches of one colour query over an area, kept up to date from frame to frame by rescanning only the tiles a
+ *  FrameDiff reports as changed. count is the amount of set bits in mask. CTSNum, hueMod and satMod are the
+ *  comparison settings the mask was matched with.
+ **/
+typedef struct ColourWatch_t
+{
+    rgb32 colour;
+    uint16_t tolerance;
+    int16_t CTSNum;
+    float hueMod, satMod;
+    MatchMask mask;
+    uint64_t count;
+    uint64_t frame;
+} ColourWatch;
+
+
+
+/** @brief Initialises a frame diff that has not seen any frame. No memory is allocated by this function.
+ *
+ * @param diff FrameDiff* Pointer to the FrameDiff structure to be initialised.
+ * @return void
+ *
+ */
+extern void initFrameDiff(FrameDiff *diff);
+
+
+/** @brief Frees the memory of a frame diff and resets it to not having seen any frame.
+ *
+ * @param diff FrameDiff* Pointer to the frame diff to be freed.
+ * @return void
+ *
+ */
+extern void freeFrameDiff(FrameDiff *diff);
+
+
+/** @brief Compares the frame searches read (the target view or targetImage) with the frame seen by the last call
+ *         and marks the tiles that differ. Rows are compared by the SIMD difference kernels and tile rows are spread
+ *         across the worker pool. Only changed tiles are copied for the next comparison. The first frame, and any frame
+ *         whose size or pixel layout changed, marks every tile. When any tile is marked, the CTSInfo starts a new
+ *         frame, so data derived from the previous one, such as the colour index, is rebuilt on first use.
+ *
+ * @param diff FrameDiff* A pointer to an initialised frame diff.
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose frame and worker pool to use.
+ * @return bool Returns true if the tiles were marked; false if there is no frame or memory ran out, in which case the
+ *              diff is reset so that the next call marks every tile.
+ *
+ */
+extern bool updateFrameDiff(FrameDiff *diff, CTSInfo *info);
+
+
+/** @brief Initialises a watch over a colour query. The first update scans the whole area.
+ *
+ * @param watch ColourWatch* Pointer to the ColourWatch structure to be initialised.
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to match.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to watch.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to watch.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to watch.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to watch.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @return bool Returns true if the watch was initialised; false if the area is empty or memory ran out.
+ *
+ */
+extern bool initColourWatch(ColourWatch *watch, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+
+
+/** @brief Frees the memory of a colour watch.
+ *
+ * @param watch ColourWatch* Pointer to the colour watch to be freed.
+ * @return void
+ *
+ */
+extern void freeColourWatch(ColourWatch *watch);
+
+
+/** @brief Brings a watch up to date with the frame a diff was last updated with. Only the dirty tiles within the area
+ *         are rescanned, and the mask and count are patched in place. The whole area is rescanned instead when the
+ *         watch missed an update of the diff or the current CTS or its hue and saturation modifiers differ from the
+ *         ones it was last updated with.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose frame and comparator functions to use. Its frame must be
+ *                      the one the diff was last updated with.
+ * @param watch ColourWatch* A pointer to the watch to update.
+ * @param diff const FrameDiff* A pointer to the frame diff updated for the current frame.
+ * @return bool Returns true if the watch is up to date; false if memory ran out, in which case the next update rescans the whole area.
+ *
+ */
+extern bool updateColourWatch(CTSInfo *info, ColourWatch *watch, const FrameDiff *diff);
+
+
+/** @brief Retrieves the matches of a watch in row-major order.
+ *
+ * @param watch const ColourWatch* A pointer to an updated watch.
+ * @param points PointArray* A pointer to an initialised PointArray structure whose contents are replaced by the matches.
+ * @return bool Returns true if any match exists; false if there is none or memory ran out.
+ *
+ */
+extern bool colourWatchPoints(const ColourWatch *watch, PointArray *points);
+
+#endif // __framediff_h_
@@ -0,0 +1,83 @@
+#ifndef __integral_h_
+#define __integral_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "finder.h"
+
+/** Cell (X, Y) holds the totals of all pixels above and left of pixel (X, Y). Channel sums are kept in 32 bits and
+ *  wrap on very large frames; window sums are still exact because they are differences below 2^32.
+ **/
+typedef struct IntegralImage_t
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t *sums; //(width + 1) * (height + 1) cells of r, g and b.
+    uint64_t *energy; //(width + 1) * (height + 1) cells of r * r + g * g + b * b.
+} IntegralImage;
+
+typedef struct RegionStats_t
+{
+    uint32_t count;
+    double mean[3];
+    double variance; //Total variance of the three channels.
+} RegionStats;
+
+
+
+/** @brief Builds the summed-area tables of an image.
+ *
+ * @param image bitmap* Pointer to the image to sum.
+ * @return IntegralImage* A pointer to the tables or NULL on failure. Must be freed using freeIntegralImage().
+ *
+ */
+extern IntegralImage *createIntegralImage(bitmap *image);
+
+
+/** @brief Frees tables created by createIntegralImage().
+ *
+ * @param integral IntegralImage* Pointer to the tables to be freed. May be NULL.
+ * @return void
+ *
+ */
+extern void freeIntegralImage(IntegralImage *integral);
+
+
+/** @brief Retrieves the summed-area tables of the target image, building them once per frame.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target to use.
+ * @return const IntegralImage* A pointer to the tables or NULL on failure. Valid until the frame changes.
+ *
+ */
+extern const IntegralImage *getIntegralImage(CTSInfo *info);
+
+
+/** @brief Computes the mean of every channel and the total variance of a specified area of the target in constant time.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target to use.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area.
+ * @param stats RegionStats* A pointer to a structure that will contain the statistics of the area.
+ * @return bool Returns true if the area is not empty and the tables could be built; false otherwise.
+ *
+ */
+extern bool getRegionStats(CTSInfo *info, int32_t x1, int32_t y1, int32_t x2, int32_t y2, RegionStats *stats);
+
+
+/** @brief Tests whether a template can match at a position by comparing the sums and energies of its opaque rectangles.
+ *         A false result guarantees that the pixel-wise comparison fails as well; a true result must still be verified.
+ *
+ * @param regions const TemplateRegions* Pointer to the rectangles of the template.
+ * @param integral const IntegralImage* Pointer to the tables of the target.
+ * @param x int32_t The x-coordinate in the target of the template's upper-left corner.
+ * @param y int32_t The y-coordinate in the target of the template's upper-left corner.
+ * @param CTSNum int16_t A CTS value from -1 to 1 inclusive. Other comparisons have no window-sum bound and always pass.
+ * @param tolerance uint16_t Tolerance threshold of the pixel-wise comparison.
+ * @return bool Returns false if no pixel-wise match is possible at the position; true otherwise.
+ *
+ */
+extern bool matchTemplateRegions(const TemplateRegions *regions, const IntegralImage *integral, int32_t x, int32_t y, int16_t CTSNum, uint16_t tolerance);
+
+#endif // __integral_h_
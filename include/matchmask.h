@@ -0,0 +1,150 @@
+#ifndef __matchmask_h_
+#define __matchmask_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "finder.h"
+
+/** One bit per pixel of the area [x1, x2) x [y1, y2) of the target. Bit I of a row stands for column x1 + I and
+ *  every row starts on a fresh word; the bits past x2 in a row's last word are always clear.
+ **/
+typedef struct MatchMask_t
+{
+    int32_t x1, y1, x2, y2;
+    uint32_t words;
+    uint32_t *bits;
+    size_t capacity;
+} MatchMask;
+
+
+
+/** @brief Initialises a mask covering no pixels. No memory is allocated by this function.
+ *
+ * @param mask MatchMask* Pointer to the MatchMask structure to be initialised.
+ * @return void
+ *
+ */
+extern void initMatchMask(MatchMask *mask);
+
+
+/** @brief Frees the memory of a mask and resets it to cover no pixels.
+ *
+ * @param mask MatchMask* Pointer to the mask to be freed.
+ * @return void
+ *
+ */
+extern void freeMatchMask(MatchMask *mask);
+
+
+/** @brief Sets the area a mask covers and clears all of its bits. Memory is kept and only grown when needed.
+ *
+ * @param mask MatchMask* Pointer to an initialised mask.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area.
+ * @return bool Returns true if the mask covers the area; false if the area is empty or memory ran out.
+ *
+ */
+extern bool resizeMatchMask(MatchMask *mask, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+
+
+/** @brief Marks every pixel of a specified area that is similar to a colour. Rows are matched by the SIMD mask kernels
+ *         for CTS -1 to 1 and across the worker pool for large areas.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target, comparator functions and worker pool to use.
+ * @param mask MatchMask* A pointer to an initialised mask that is resized to the area and filled.
+ * @param colour rgb32* A pointer to an RGB structure representing the colour to match.
+ * @param x1 int32_t The x-coordinate of the upper-left corner of the area to search.
+ * @param y1 int32_t The y-coordinate of the upper-left corner of the area to search.
+ * @param x2 int32_t The x-coordinate of the lower-right corner of the area to search.
+ * @param y2 int32_t The y-coordinate of the lower-right corner of the area to search.
+ * @param tolerance uint16_t Tolerance threshold defining how strict the comparison will be.
+ * @return bool Returns true if the mask was filled; false if the area is empty or memory ran out.
+ *
+ */
+extern bool findColoursMask(CTSInfo *info, MatchMask *mask, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+
+
+/** @brief Keeps the bits of a mask that are also set in another mask covering the same area.
+ *
+ * @param mask MatchMask* Pointer to the mask to update.
+ * @param other const MatchMask* Pointer to the mask to combine with.
+ * @return bool Returns true if the masks were combined; false if they cover different areas.
+ *
+ */
+extern bool andMatchMask(MatchMask *mask, const MatchMask *other);
+
+
+/** @brief Sets the bits of a mask that are set in another mask covering the same area.
+ *
+ * @param mask MatchMask* Pointer to the mask to update.
+ * @param other const MatchMask* Pointer to the mask to combine with.
+ * @return bool Returns true if the masks were combined; false if they cover different areas.
+ *
+ */
+extern bool orMatchMask(MatchMask *mask, const MatchMask *other);
+
+
+/** @brief Flips the bits of a mask that are set in another mask covering the same area.
+ *
+ * @param mask MatchMask* Pointer to the mask to update.
+ * @param other const MatchMask* Pointer to the mask to combine with.
+ * @return bool Returns true if the masks were combined; false if they cover different areas.
+ *
+ */
+extern bool xorMatchMask(MatchMask *mask, const MatchMask *other);
+
+
+/** @brief Flips every bit of a mask.
+ *
+ * @param mask MatchMask* Pointer to the mask to update.
+ * @return void
+ *
+ */
+extern void notMatchMask(MatchMask *mask);
+
+
+/** @brief Sets every bit within radius pixels (horizontally and vertically) of a set bit, so that a mask of one colour
+ *         becomes a mask of the pixels near that colour.
+ *
+ * @param mask MatchMask* Pointer to the mask to update.
+ * @param radius uint32_t The half-width of the square each set bit grows to.
+ * @return bool Returns true if the mask was grown; false if memory ran out.
+ *
+ */
+extern bool dilateMatchMask(MatchMask *mask, uint32_t radius);
+
+
+/** @brief Counts the set bits of a mask.
+ *
+ * @param mask const MatchMask* Pointer to the mask to count.
+ * @return uint64_t The amount of set bits.
+ *
+ */
+extern uint64_t countMatchMask(const MatchMask *mask);
+
+
+/** @brief Retrieves the smallest area holding every set bit of a mask.
+ *
+ * @param mask const MatchMask* Pointer to the mask.
+ * @param x1 int32_t* A pointer to an integer that will contain the smallest x-coordinate of a set bit.
+ * @param y1 int32_t* A pointer to an integer that will contain the smallest y-coordinate of a set bit.
+ * @param x2 int32_t* A pointer to an integer that will contain one past the largest x-coordinate of a set bit.
+ * @param y2 int32_t* A pointer to an integer that will contain one past the largest y-coordinate of a set bit.
+ * @return bool Returns true if any bit is set; false otherwise.
+ *
+ */
+extern bool matchMaskBounds(const MatchMask *mask, int32_t *x1, int32_t *y1, int32_t *x2, int32_t *y2);
+
+
+/** @brief Appends the position of every set bit of a mask to a PointArray in row-major order.
+ *
+ * @param mask const MatchMask* Pointer to the mask.
+ * @param points PointArray* A pointer to an initialised PointArray structure the positions are appended to.
+ * @return bool Returns true if all positions were appended; false if memory ran out.
+ *
+ */
+extern bool matchMaskPoints(const MatchMask *mask, PointArray *points);
+
+#endif // __matchmask_h_
@@ -0,0 +1,95 @@
+#ifndef __points_h_
+#define __points_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+typedef struct Point_t
+{
+    int32_t x;
+    int32_t y;
+} Point;
+
+typedef struct PointArray_t
+{
+    Point* p;
+    size_t size;
+    size_t capacity;
+    bool fixed; //p is owned elsewhere: the array never grows or frees it and appending past capacity fails. See initFixedPointArray().
+} PointArray;
+
+
+
+/** @brief Initialises a point array. All values are set to default. No memory is allocated by this function.
+ *
+ * @param pa PointArray* Pointer to the PointArray structure to be initialised.
+ * @return void
+ *
+ */
+extern void initPointArray(PointArray* pa);
+
+
+/** @brief Initialises a point array over memory owned elsewhere, such as a slice of a larger array. Appends store into
+ *         that memory until it is full and fail afterwards; it is never reallocated or freed.
+ *
+ * @param pa PointArray* Pointer to the PointArray structure to be initialised.
+ * @param points Point* Pointer to the memory to hold the points.
+ * @param capacity size_t The amount of points the memory can hold.
+ * @return void
+ *
+ */
+extern void initFixedPointArray(PointArray* pa, Point *points, size_t capacity);
+
+
+/** @brief Frees a PointArray and nullifies all data-members.
+ *
+ * @param pa PointArray* Pointer to the structure to be freed. free() is called on the data-member p unless the array is fixed.
+ * @return extern void
+ *
+ */
+extern void freePointArray(PointArray* pa);
+
+
+/** @brief Empties a PointArray without releasing its memory so that it can be refilled without allocating.
+ *
+ * @param pa PointArray* Pointer to the structure to be emptied.
+ * @return void
+ *
+ */
+extern void clearPointArray(PointArray* pa);
+
+
+/** @brief Ensures a PointArray can hold at least the specified amount of points without reallocating.
+ *
+ * @param pa PointArray* Pointer to the structure to grow. Its points are preserved.
+ * @param capacity size_t The amount of points the array must be able to hold.
+ * @return bool Returns true if the array can hold the specified amount of points; false if memory could not be allocated
+ *              or a fixed array is too small.
+ *
+ */
+extern bool reservePointArray(PointArray* pa, size_t capacity);
+
+
+/** @brief Appends a point to a PointArray, growing its capacity geometrically when full.
+ *
+ * @param pa PointArray* Pointer to the structure to append to.
+ * @param x int32_t The x-coordinate of the point.
+ * @param y int32_t The y-coordinate of the point.
+ * @return bool Returns true if the point was appended; false if memory could not be allocated or a fixed array is full.
+ *
+ */
+extern bool appendPoint(PointArray* pa, int32_t x, int32_t y);
+
+
+/** @brief Appends an array of points to a PointArray.
+ *
+ * @param pa PointArray* Pointer to the structure to append to.
+ * @param points const Point* Pointer to the points to be copied.
+ * @param count size_t The amount of points to be copied.
+ * @return bool Returns true if the points were appended; false if memory could not be allocated or a fixed array is too small.
+ *
+ */
+extern bool appendPoints(PointArray* pa, const Point *points, size_t count);
+
+#endif // __points_h_
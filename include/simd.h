@@ -0,0 +1,86 @@
+#ifndef __simd_h_
+#define __simd_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "color.h"
+
+#if (defined __x86_64__ || defined __i386__) && defined __GNUC__
+#define SIMD_X86
+#endif
+
+typedef enum {SIMDNone, SIMDSSE2, SIMDAVX2, SIMDAVX512} SIMDLevel;
+
+typedef uint32_t (*countRowT)(const rgb32 *row, uint32_t count, const rgb32 *colour, uint16_t tol);
+typedef int32_t (*findRowT)(const rgb32 *row, uint32_t count, const rgb32 *colour, uint16_t tol);
+typedef uint32_t (*maskRowT)(const rgb32 *row, uint32_t count, const rgb32 *colour, uint16_t tol, uint32_t *bits);
+
+typedef uint32_t (*diffRowT)(const rgb32 *first, const rgb32 *second, uint32_t count);
+
+typedef struct SIMDKernels_t
+{
+    countRowT count;
+    findRowT find;
+    maskRowT mask;
+} SIMDKernels;
+
+typedef struct SIMDDiffKernels_t
+{
+    diffRowT ssd;
+    diffRowT sad;
+} SIMDDiffKernels;
+
+
+
+/** @brief Retrieves the highest instruction set supported by the processor and operating system.
+ *
+ * @return SIMDLevel The best instruction set detected via CPUID when the library was loaded.
+ *
+ */
+extern SIMDLevel getSupportedSIMDLevel(void);
+
+
+/** @brief Retrieves the instruction set whose kernels are currently used by the finder.
+ *
+ * @return SIMDLevel The active instruction set.
+ *
+ */
+extern SIMDLevel getSIMDLevel(void);
+
+
+/** @brief Selects the instruction set whose kernels the finder should use.
+ *         Intended for benchmarking and for comparing against the scalar reference (SIMDNone).
+ *         Must not be called while a search is running.
+ *
+ * @param level SIMDLevel The instruction set to use. Clamped to the supported level.
+ * @return SIMDLevel The instruction set actually selected.
+ *
+ */
+extern SIMDLevel setSIMDLevel(SIMDLevel level);
+
+
+/** @brief Retrieves the row kernels for a comparison mode.
+ *
+ *         count returns the amount of matching pixels in a row.
+ *         find returns the index of the first matching pixel in a row or -1.
+ *         mask sets bit I of bits (an array of (count + 31) / 32 words) for each matching pixel I and returns the amount of matches.
+ *
+ * @param CTSNum int16_t A CTS value from -1 to 3 inclusive.
+ * @return const SIMDKernels* The kernels for CTS -1, 0 and 1. NULL for any other CTS.
+ *
+ */
+extern const SIMDKernels *getSIMDKernels(int16_t CTSNum);
+
+
+
+/** @brief Retrieves the row kernels that measure how much two runs of pixels differ. The alpha channel is ignored.
+ *
+ *         ssd returns the sum of squared and sad the sum of absolute per-channel differences of count pixel pairs.
+ *         count must not exceed 4096 so that the sums fit 32 bits.
+ *
+ * @return const SIMDDiffKernels* The kernels of the active instruction set.
+ *
+ */
+extern const SIMDDiffKernels *getSIMDDiffKernels(void);
+
+#endif // __simd_h_
@@ -0,0 +1,134 @@
+#ifndef __template_h_
+#define __template_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "bitmap.h"
+
+/** Levels are ordered from finest to coarsest. Level L sums blocks of (2 << L) x (2 << L) pixels. **/
+#define PYRAMID_LEVELS 2
+
+typedef struct BlockSum_t
+{
+    uint16_t r, g, b, a;
+} BlockSum;
+
+typedef struct PyramidLevel_t
+{
+    uint32_t factor;
+    uint32_t width;
+    uint32_t height;
+    BlockSum *sums;
+} PyramidLevel;
+
+typedef struct FramePyramid_t
+{
+    PyramidLevel levels[PYRAMID_LEVELS];
+} FramePyramid;
+
+typedef struct TemplateBlock_t
+{
+    int32_t x, y;
+    BlockSum sum;
+} TemplateBlock;
+
+typedef struct TemplateLevel_t
+{
+    uint32_t factor;
+    TemplateBlock *blocks;
+    uint32_t offsets[(2 << (PYRAMID_LEVELS - 1)) * (2 << (PYRAMID_LEVELS - 1)) + 1];
+} TemplateLevel;
+
+/** At most this many of the largest fully opaque rectangles of an image are kept for window-sum tests. **/
+#define TEMPLATE_REGIONS 8
+
+typedef struct TemplateRegion_t
+{
+    int32_t x, y;
+    uint32_t width, height;
+    uint64_t sum[3];
+    uint64_t energy; //Sum of r * r + g * g + b * b.
+} TemplateRegion;
+
+typedef struct TemplateRegions_t
+{
+    TemplateRegion regions[TEMPLATE_REGIONS];
+    uint32_t count;
+} TemplateRegions;
+
+typedef struct Template_t
+{
+    bitmap *image;
+    uint32_t *order; //Indices of the opaque pixels, most distinctive first.
+    uint32_t count;
+    TemplateLevel levels[PYRAMID_LEVELS];
+    TemplateRegions regions;
+} Template;
+
+
+
+/** @brief Prepares an image for repeated searches. The image's block sums are computed once for every
+ *         alignment against the target's pyramid so that candidate positions can be rejected at a coarse level.
+ *         Its opaque pixels are ordered so that the rarest colours of the image are compared first: on a background
+ *         made of the image's common colours a position then fails on its first few pixels instead of deep into a row.
+ *
+ * @param tpl Template* Pointer to the Template structure to be filled. Must be freed using freeTemplate().
+ * @param image bitmap* Pointer to the image to search for. It is referenced, not copied, and must outlive the template.
+ * @return bool Returns true if the template was created; false otherwise.
+ *
+ */
+extern bool createTemplate(Template *tpl, bitmap *image);
+
+
+/** @brief Splits the opaque pixels of an image into rectangles and keeps the largest ones with their channel sums.
+ *
+ * @param regions TemplateRegions* Pointer to the structure that will contain the rectangles. No memory is allocated.
+ * @param image bitmap* Pointer to the image to split.
+ * @return bool Returns true if the image has at least one opaque pixel; false otherwise.
+ *
+ */
+extern bool createTemplateRegions(TemplateRegions *regions, bitmap *image);
+
+
+/** @brief Frees a Template and nullifies all data-members. The referenced image is not freed.
+ *
+ * @param tpl Template* Pointer to the Template structure to be freed.
+ * @return void
+ *
+ */
+extern void freeTemplate(Template *tpl);
+
+
+/** @brief Builds the block sums of every pyramid level of an image.
+ *
+ * @param image bitmap* Pointer to the image to downsample.
+ * @return FramePyramid* A pointer to the pyramid or NULL on failure. Must be freed using freeFramePyramid().
+ *
+ */
+extern FramePyramid *createFramePyramid(bitmap *image);
+
+
+/** @brief Frees a pyramid created by createFramePyramid().
+ *
+ * @param pyramid FramePyramid* Pointer to the pyramid to be freed. May be NULL.
+ * @return void
+ *
+ */
+extern void freeFramePyramid(FramePyramid *pyramid);
+
+
+/** @brief Tests whether a template can match at a position by comparing block sums, coarsest level first.
+ *         A false result guarantees that the pixel-wise comparison fails as well; a true result must still be verified.
+ *
+ * @param tpl const Template* Pointer to the template to test.
+ * @param pyramid const FramePyramid* Pointer to the pyramid of the target.
+ * @param x int32_t The x-coordinate in the target of the template's upper-left corner.
+ * @param y int32_t The y-coordinate in the target of the template's upper-left corner.
+ * @param CTSNum int16_t A CTS value from -1 to 1 inclusive. Other comparisons have no block-sum bound and always pass.
+ * @param tolerance uint16_t Tolerance threshold of the pixel-wise comparison.
+ * @return bool Returns false if no pixel-wise match is possible at the position; true otherwise.
+ *
+ */
+extern bool matchTemplateCoarse(const Template *tpl, const FramePyramid *pyramid, int32_t x, int32_t y, int16_t CTSNum, uint16_t tolerance);
+
+#endif // __template_h_
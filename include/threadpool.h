@@ -0,0 +1,53 @@
+#ifndef __threadpool_h_
+#define __threadpool_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct ThreadPool_t ThreadPool;
+
+typedef void (*TaskFunc)(void *data, uint32_t index);
+
+
+
+/** @brief Creates a pool of persistent worker threads.
+ *
+ * @param threads uint32_t The amount of threads that run tasks, including the thread calling parallelFor(). Zero uses one per online processor.
+ * @return ThreadPool* A pointer to the pool or NULL if it could not be created. Must be freed using freeThreadPool().
+ *
+ */
+extern ThreadPool *createThreadPool(uint32_t threads);
+
+
+/** @brief Stops all workers of a pool and frees it.
+ *
+ * @param pool ThreadPool* A pointer to the pool to be freed. May be NULL.
+ * @return void
+ *
+ */
+extern void freeThreadPool(ThreadPool *pool);
+
+
+/** @brief Retrieves the amount of threads that run the tasks of a pool.
+ *
+ * @param pool ThreadPool* A pointer to the pool. May be NULL.
+ * @return uint32_t The amount of threads including the caller. One if the pool is NULL.
+ *
+ */
+extern uint32_t threadPoolSize(ThreadPool *pool);
+
+
+/** @brief Runs func(data, index) for every index in [0, count) and blocks until all of them have finished.
+ *         The calling thread takes part in the work. When the pool is NULL or already busy (for example when
+ *         called from one of its own tasks) all tasks run on the calling thread instead.
+ *
+ * @param pool ThreadPool* A pointer to the pool that runs the tasks. May be NULL.
+ * @param count uint32_t The amount of tasks.
+ * @param func TaskFunc The function to run for each task.
+ * @param data void* A pointer handed to every task.
+ * @return void
+ *
+ */
+extern void parallelFor(ThreadPool *pool, uint32_t count, TaskFunc func, void *data);
+
+#endif // __threadpool_h_
@@ -0,0 +1,77 @@
+#ifndef __tilebounds_h_
+#define __tilebounds_h_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "finder.h"
+
+#define TILE_BOUNDS_SIZE 32
+#define TILE_BOUNDS_BINS 512
+
+typedef struct TileBounds_t TileBounds;
+
+typedef struct TileQuery_t
+{
+    const TileBounds *bounds;
+    int32_t colour[3];
+    int32_t tol;
+    bool euclidean;
+    uint64_t bins[TILE_BOUNDS_BINS / 64];
+} TileQuery;
+
+
+
+/** @brief Splits an image into square tiles and records the per-channel range and the coarse colours (3 bits per
+ *         channel) present in each tile. The alpha channel is ignored.
+ *
+ * @param image bitmap* Pointer to the image to summarise.
+ * @return TileBounds* A pointer to the tile bounds or NULL on failure. Must be freed using freeTileBounds().
+ *
+ */
+extern TileBounds *createTileBounds(bitmap *image);
+
+
+/** @brief Frees tile bounds created by createTileBounds().
+ *
+ * @param bounds TileBounds* Pointer to the tile bounds to be freed. May be NULL.
+ * @return void
+ *
+ */
+extern void freeTileBounds(TileBounds *bounds);
+
+
+/** @brief Retrieves the tile bounds of the target image, building them once per frame.
+ *
+ * @param info CTSInfo* A pointer to the CTSInfo structure whose target to use.
+ * @return const TileBounds* A pointer to the tile bounds or NULL on failure. Valid until the frame changes.
+ *
+ */
+extern const TileBounds *getTileBounds(CTSInfo *info);
+
+
+/** @brief Prepares a query that tells which tiles may hold a pixel similar to a colour.
+ *
+ * @param query TileQuery* A pointer to the TileQuery structure to fill.
+ * @param bounds const TileBounds* A pointer to the tile bounds to query.
+ * @param CTSNum int16_t The CTS used to compare colours.
+ * @param colour const rgb32* A pointer to the colour searched for.
+ * @param tol uint16_t The tolerance used to compare colours.
+ * @return bool Returns true if the query was prepared; false if tiles cannot be bounded for the CTS (2 and 3).
+ *
+ */
+extern bool prepareTileQuery(TileQuery *query, const TileBounds *bounds, int16_t CTSNum, const rgb32 *colour, uint16_t tol);
+
+
+/** @brief Lists the runs of a row, within [x1, x2), that lie in tiles which may hold a match. Adjacent tiles are merged.
+ *
+ * @param query const TileQuery* A pointer to a query prepared by prepareTileQuery().
+ * @param y int32_t The row whose tiles to test.
+ * @param x1 int32_t The first column of the row to consider.
+ * @param x2 int32_t The column after the last one to consider.
+ * @param runs int32_t* An array of at least 2 * ((x2 - x1) / TILE_BOUNDS_SIZE + 2) integers receiving the start and end of each run.
+ * @return uint32_t The amount of runs.
+ *
+ */
+extern uint32_t tileQueryRuns(const TileQuery *query, int32_t y, int32_t x1, int32_t x2, int32_t *runs);
+
+#endif // __tilebounds_h_
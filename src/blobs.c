@@ -0,0 +1,211 @@
+#include "blobs.h"
+
+/** A maximal span of set bits within one row. Right is exclusive. **/
+typedef struct
+{
+    int32_t y, left, right;
+} __Run;
+
+typedef struct
+{
+    __Run *runs;
+    uint32_t *parents;
+    size_t count, capacity;
+} __RunList;
+
+static bool __appendRun(__RunList *list, int32_t y, int32_t left, int32_t right)
+{
+    if (list->count == list->capacity)
+    {
+        size_t capacity = list->capacity ? list->capacity * 2 : 1024;
+        if (capacity > UINT32_MAX)
+            return false;
+
+        __Run *runs = realloc(list->runs, capacity * sizeof(__Run));
+        if (!runs)
+            return false;
+        list->runs = runs;
+
+        uint32_t *parents = realloc(list->parents, capacity * sizeof(uint32_t));
+        if (!parents)
+            return false;
+        list->parents = parents;
+        list->capacity = capacity;
+    }
+
+    __Run run = {y, left, right};
+    list->runs[list->count] = run;
+    list->parents[list->count] = (uint32_t)list->count;
+    ++list->count;
+    return true;
+}
+
+/** The position of the first bit at or after from that equals set, or width if there is none. **/
+static int32_t __nextBit(const uint32_t *bits, int32_t from, int32_t width, bool set)
+{
+    while (from < width)
+    {
+        uint32_t word = (set ? bits[from >> 5] : ~bits[from >> 5]) >> (from & 31);
+        if (word)
+        {
+            from += __builtin_ctz(word);
+            return from < width ? from : width;
+        }
+        from = (from | 31) + 1;
+    }
+    return width;
+}
+
+static bool __appendRowRuns(__RunList *list, const MatchMask *mask, int32_t row)
+{
+    int32_t left, right = 0, width = mask->x2 - mask->x1;
+    const uint32_t *bits = &mask->bits[(size_t)row * mask->words];
+
+    while ((left = __nextBit(bits, right, width, true)) < width)
+    {
+        right = __nextBit(bits, left, width, false);
+        if (!__appendRun(list, mask->y1 + row, mask->x1 + left, mask->x1 + right))
+            return false;
+    }
+    return true;
+}
+
+static uint32_t __findRoot(uint32_t *parents, uint32_t index)
+{
+    while (parents[index] != index)
+    {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+    return index;
+}
+
+/** Roots are always the earliest run of their component, so components come out in order of their first pixel. **/
+static void __unite(uint32_t *parents, uint32_t first, uint32_t second)
+{
+    first = __findRoot(parents, first);
+    second = __findRoot(parents, second);
+    if (first < second)
+        parents[second] = first;
+    else
+        parents[first] = second;
+}
+
+/** Runs of consecutive rows touch (8-connected) when each starts no further right than one past the other's end.
+ *  Both rows are sorted, so one sweep pairs every run with the runs above it.
+ **/
+static void __uniteRows(__RunList *list, size_t above, size_t current, size_t end)
+{
+    size_t I, J;
+    for (I = current; I < end; ++I)
+    {
+        const __Run *run = &list->runs[I];
+        while (above < current && list->runs[above].right < run->left)
+            ++above;
+
+        for (J = above; J < current && list->runs[J].left <= run->right; ++J)
+            __unite(list->parents, (uint32_t)I, (uint32_t)J);
+    }
+}
+
+static bool __collectBlobs(__RunList *list, BlobArray *blobs, uint64_t minArea)
+{
+    size_t I, count = 0, kept = 0;
+    uint32_t *ids = malloc(list->count * sizeof(uint32_t) + 1);
+    Blob *found = malloc(list->count * sizeof(Blob) + 1);
+    int64_t *sums = calloc(2 * list->count + 1, sizeof(int64_t));
+    bool Result = ids && found && sums;
+
+    for (I = 0; I < list->count && Result; ++I)
+    {
+        const __Run *run = &list->runs[I];
+        uint32_t root = __findRoot(list->parents, (uint32_t)I);
+        int64_t length = run->right - run->left;
+
+        if (root == I)
+        {
+            Blob blob = {0, run->left, run->y, run->right, run->y + 1, 0, 0};
+            ids[I] = (uint32_t)count;
+            found[count++] = blob;
+        }
+        else
+        {
+            ids[I] = ids[root];
+        }
+
+        Blob *blob = &found[ids[I]];
+        blob->area += length;
+        blob->x1 = run->left < blob->x1 ? run->left : blob->x1;
+        blob->x2 = run->right > blob->x2 ? run->right : blob->x2;
+        blob->y2 = run->y + 1;
+        sums[2 * ids[I]] += length * ((int64_t)run->left + run->right - 1);
+        sums[2 * ids[I] + 1] += length * run->y;
+    }
+
+    for (I = 0; I < count && Result; ++I)
+    {
+        if (found[I].area < minArea)
+            continue;
+
+        found[I].centreX = (double)sums[2 * I] / 2.0 / found[I].area;
+        found[I].centreY = (double)sums[2 * I + 1] / found[I].area;
+        found[kept++] = found[I];
+    }
+
+    free(ids);
+    free(sums);
+    if (!Result || !kept)
+    {
+        free(found);
+        return false;
+    }
+
+    Blob *shrunk = realloc(found, kept * sizeof(Blob));
+    blobs->blobs = shrunk ? shrunk : found;
+    blobs->count = kept;
+    return true;
+}
+
+bool findMaskBlobs(const MatchMask *mask, BlobArray *blobs, uint64_t minArea)
+{
+    int32_t I;
+    size_t above = 0;
+    __RunList list = {NULL, NULL, 0, 0};
+    bool Result = true;
+
+    blobs->blobs = NULL;
+    blobs->count = 0;
+
+    for (I = 0; I < mask->y2 - mask->y1 && Result; ++I)
+    {
+        size_t current = list.count;
+        Result = __appendRowRuns(&list, mask, I);
+        __uniteRows(&list, above, current, list.count);
+        above = current;
+    }
+
+    Result = Result && list.count && __collectBlobs(&list, blobs, minArea);
+    free(list.runs);
+    free(list.parents);
+    return Result;
+}
+
+bool findBlobs(CTSInfo *info, BlobArray *blobs, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance, uint64_t minArea)
+{
+    MatchMask mask;
+    initMatchMask(&mask);
+
+    blobs->blobs = NULL;
+    blobs->count = 0;
+
+    bool Result = findColoursMask(info, &mask, colour, x1, y1, x2, y2, tolerance) && findMaskBlobs(&mask, blobs, minArea);
+    freeMatchMask(&mask);
+    return Result;
+}
+
+void freeBlobArray(BlobArray *blobs)
+{
+    free(blobs->blobs);
+    blobs->blobs = NULL;
+    blobs->count = 0;
+}
@@ -2,10 +2,20 @@
 
 Client initClient(IOManager *io)
 {
-
+    Client client = {0};
+    client.ownIO = false;
+    client.io = io;
+    initFinder(&client.finder, 0);
+    return client;
 }
 
 void freeClient(Client *client)
 {
+    freeFinder(&client->finder);
+
+    if (client->ownIO)
+        free(client->io);
 
+    client->io = NULL;
+    client->ownIO = false;
 }
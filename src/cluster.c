@@ -0,0 +1,439 @@
+#include "cluster.h"
+
+#include <math.h>
+#include <string.h>
+
+#define EMPTY_CELL UINT32_MAX
+
+/** Maps grid cells to values. While the cells spanned by the points are few compared to the points they are held
+ *  in a dense array, which keeps neighbouring cells close in memory; otherwise they are found through an
+ *  open-addressed table keyed on their coordinates. A cell is empty while its value is EMPTY_CELL.
+ **/
+#define DENSE_CELLS_PER_POINT 4
+
+typedef struct
+{
+    int32_t size;
+    int32_t left, top;
+    uint32_t width, height;
+    uint64_t *keys;
+    uint32_t *values;
+    uint32_t mask;
+} __CellGrid;
+
+static inline int32_t __cellOf(int32_t value, int32_t size)
+{
+    return value >= 0 ? value / size : -((-(int64_t)value - 1) / size) - 1;
+}
+
+static inline uint64_t __cellKey(int32_t cellX, int32_t cellY)
+{
+    return ((uint64_t)(uint32_t)cellX << 32) | (uint32_t)cellY;
+}
+
+static bool __initCellGrid(__CellGrid *grid, const PointArray *points, int32_t size)
+{
+    size_t I, count = 16;
+    int32_t left = INT32_MAX, top = INT32_MAX, right = INT32_MIN, bottom = INT32_MIN;
+
+    for (I = 0; I < points->size; ++I)
+    {
+        int32_t cellX = __cellOf(points->p[I].x, size), cellY = __cellOf(points->p[I].y, size);
+        left = cellX < left ? cellX : left;
+        top = cellY < top ? cellY : top;
+        right = cellX > right ? cellX : right;
+        bottom = cellY > bottom ? cellY : bottom;
+    }
+
+    memset(grid, 0, sizeof(__CellGrid));
+    grid->size = size;
+    grid->left = left;
+    grid->top = top;
+
+    if (points->size && ((uint64_t)right - left + 1) * ((uint64_t)bottom - top + 1) <= (uint64_t)points->size * DENSE_CELLS_PER_POINT + 4096)
+    {
+        grid->width = right - left + 1;
+        grid->height = bottom - top + 1;
+        count = (size_t)grid->width * grid->height;
+    }
+    else
+    {
+        while (count < points->size * 2)
+            count <<= 1;
+
+        grid->mask = count - 1;
+        if (!(grid->keys = malloc(count * sizeof(uint64_t))))
+            return false;
+    }
+
+    if (!(grid->values = malloc(count * sizeof(uint32_t))))
+        return false;
+
+    for (I = 0; I < count; ++I)
+        grid->values[I] = EMPTY_CELL;
+    return true;
+}
+
+static void __freeCellGrid(__CellGrid *grid)
+{
+    free(grid->keys);
+    free(grid->values);
+}
+
+/** Returns the slot of a cell. Hashed cells that are not yet stored get the free slot where they belong, and dense
+ *  cells outside the array get UINT32_MAX.
+ **/
+static inline uint32_t __cellSlot(const __CellGrid *grid, int32_t cellX, int32_t cellY)
+{
+    if (grid->width)
+    {
+        uint32_t X = (uint32_t)(cellX - grid->left), Y = (uint32_t)(cellY - grid->top);
+        return X < grid->width && Y < grid->height ? Y * grid->width + X : UINT32_MAX;
+    }
+
+    uint64_t key = __cellKey(cellX, cellY);
+    uint32_t slot = (uint32_t)((key * 0x9E3779B97F4A7C15ULL) >> 32) & grid->mask;
+    while (grid->values[slot] != EMPTY_CELL && grid->keys[slot] != key)
+        slot = (slot + 1) & grid->mask;
+    return slot;
+}
+
+static inline uint32_t __getCell(const __CellGrid *grid, int32_t cellX, int32_t cellY)
+{
+    uint32_t slot = __cellSlot(grid, cellX, cellY);
+    return slot == UINT32_MAX ? EMPTY_CELL : grid->values[slot];
+}
+
+static inline void __setCell(__CellGrid *grid, int32_t cellX, int32_t cellY, uint32_t value)
+{
+    uint32_t slot = __cellSlot(grid, cellX, cellY);
+    if (grid->keys)
+        grid->keys[slot] = __cellKey(cellX, cellY);
+    grid->values[slot] = value;
+}
+
+static inline bool __within(const Point *first, const Point *second, double distanceSq)
+{
+    double X = (double)first->x - second->x, Y = (double)first->y - second->y;
+    return X * X + Y * Y <= distanceSq;
+}
+
+/** Lays the clusters out in one allocation: the PointClusters array followed by the points of every cluster. **/
+static bool __collectClusters(const PointArray *points, const uint32_t *labels, size_t count, PointClusters *clusters)
+{
+    size_t I;
+    clusters->clusters = NULL;
+    clusters->count = 0;
+
+    if (!count)
+        return true;
+
+    PointCluster *result = malloc(count * sizeof(PointCluster) + points->size * sizeof(Point));
+    double *sums = calloc(count * 2, sizeof(double));
+    if (!result || !sums)
+    {
+        free(result);
+        free(sums);
+        return false;
+    }
+
+    for (I = 0; I < count; ++I)
+    {
+        result[I].points.size = 0;
+        result[I].x1 = result[I].y1 = INT32_MAX;
+        result[I].x2 = result[I].y2 = INT32_MIN;
+    }
+
+    for (I = 0; I < points->size; ++I)
+        ++result[labels[I]].points.size;
+
+    Point *storage = (Point *)(result + count);
+    for (I = 0; I < count; ++I)
+    {
+        result[I].points.p = storage;
+        result[I].points.capacity = result[I].points.size;
+        storage += result[I].points.size;
+        result[I].points.size = 0;
+    }
+
+    for (I = 0; I < points->size; ++I)
+    {
+        PointCluster *cluster = &result[labels[I]];
+        const Point *point = &points->p[I];
+
+        cluster->points.p[cluster->points.size++] = *point;
+        cluster->x1 = point->x < cluster->x1 ? point->x : cluster->x1;
+        cluster->y1 = point->y < cluster->y1 ? point->y : cluster->y1;
+        cluster->x2 = point->x + 1 > cluster->x2 ? point->x + 1 : cluster->x2;
+        cluster->y2 = point->y + 1 > cluster->y2 ? point->y + 1 : cluster->y2;
+        sums[labels[I] * 2] += point->x;
+        sums[labels[I] * 2 + 1] += point->y;
+    }
+
+    for (I = 0; I < count; ++I)
+    {
+        result[I].centreX = sums[I * 2] / result[I].points.size;
+        result[I].centreY = sums[I * 2 + 1] / result[I].points.size;
+    }
+
+    free(sums);
+    clusters->clusters = result;
+    clusters->count = count;
+    return true;
+}
+
+/** Seeds are more than distance apart, so a cell as wide as distance holds only a handful of them and a point only
+ *  has to look at the seeds of its own and the eight surrounding cells. Each cell keeps its seeds in a list.
+ **/
+bool clusterPoints(const PointArray *points, double distance, PointClusters *clusters)
+{
+    size_t I, seeds = 0;
+    int32_t X, Y, size = distance < 1.0 ? 1 : (int32_t)ceil(distance);
+    double distanceSq = distance * distance;
+    __CellGrid grid;
+
+    uint32_t *labels = malloc(points->size * sizeof(uint32_t) + 1);
+    uint32_t *next = malloc(points->size * sizeof(uint32_t) + 1);
+    uint32_t *seedPoints = malloc(points->size * sizeof(uint32_t) + 1);
+
+    if (!__initCellGrid(&grid, points, size) || !labels || !next || !seedPoints)
+    {
+        __freeCellGrid(&grid);
+        free(labels);
+        free(next);
+        free(seedPoints);
+        return false;
+    }
+
+    for (I = 0; I < points->size; ++I)
+    {
+        const Point *point = &points->p[I];
+        int32_t cellX = __cellOf(point->x, size), cellY = __cellOf(point->y, size);
+        uint32_t seed, best = EMPTY_CELL;
+
+        for (Y = cellY - 1; Y <= cellY + 1; ++Y)
+        {
+            for (X = cellX - 1; X <= cellX + 1; ++X)
+            {
+                for (seed = __getCell(&grid, X, Y); seed != EMPTY_CELL; seed = next[seed])
+                {
+                    if (seed < best && __within(point, &points->p[seedPoints[seed]], distanceSq))
+                        best = seed;
+                }
+            }
+        }
+
+        if (best == EMPTY_CELL)
+        {
+            best = seeds++;
+            seedPoints[best] = I;
+            next[best] = __getCell(&grid, cellX, cellY);
+            __setCell(&grid, cellX, cellY, best);
+        }
+        labels[I] = best;
+    }
+
+    bool Result = __collectClusters(points, labels, seeds, clusters);
+    __freeCellGrid(&grid);
+    free(labels);
+    free(next);
+    free(seedPoints);
+    return Result;
+}
+
+static uint32_t __findRoot(uint32_t *parents, uint32_t index)
+{
+    while (parents[index] != index)
+    {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+    return index;
+}
+
+/** The occupied rows of a cell, each with the lowest and highest x of its points, or its occupied columns with the
+ *  lowest and highest y.
+ **/
+typedef struct
+{
+    int32_t at, low, high;
+} __Extent;
+
+/** Fills the extents of every cell along one axis (1 for rows, 0 for columns). slots maps a row or column of the cell
+ *  being filled to its extent; an entry is stale unless it points at an extent of this cell for the same line.
+ **/
+static void __cellExtents(const PointArray *points, const uint32_t *order, const uint32_t *starts, const int32_t *cellXY, size_t cells, int32_t size, int32_t axis, int32_t origin, uint32_t *slots, __Extent *extents, uint32_t *extentStarts)
+{
+    size_t I, J;
+    uint32_t count = 0;
+
+    for (I = 0; I < cells; ++I)
+    {
+        int64_t base = (int64_t)cellXY[I * 2 + axis] * size > origin ? (int64_t)cellXY[I * 2 + axis] * size : origin;
+        extentStarts[I] = count;
+
+        for (J = starts[I]; J < starts[I + 1]; ++J)
+        {
+            const Point *point = &points->p[order[J]];
+            int32_t at = axis ? point->y : point->x, across = axis ? point->x : point->y;
+            uint32_t *slot = &slots[at - base];
+
+            if (*slot < extentStarts[I] || *slot >= count || extents[*slot].at != at)
+            {
+                __Extent extent = {at, across, across};
+                *slot = count;
+                extents[count++] = extent;
+            }
+            else
+            {
+                extents[*slot].low = across < extents[*slot].low ? across : extents[*slot].low;
+                extents[*slot].high = across > extents[*slot].high ? across : extents[*slot].high;
+            }
+        }
+    }
+    extentStarts[cells] = count;
+}
+
+/** When the second cell lies wholly after the first along the extents' cross axis, every point of a connected pair
+ *  can be moved to the extent of its row or column facing the other cell without growing their distance. **/
+static bool __extentsMeet(const __Extent *first, const __Extent *firstEnd, const __Extent *second, const __Extent *secondEnd, bool after, double distanceSq)
+{
+    const __Extent *B;
+    for (; first < firstEnd; ++first)
+    {
+        double from = after ? first->high : first->low;
+        for (B = second; B < secondEnd; ++B)
+        {
+            double across = (after ? B->low : B->high) - from, along = (double)B->at - first->at;
+            if (across * across + along * along <= distanceSq)
+                return true;
+        }
+    }
+    return false;
+}
+
+/** Cells are narrow enough (distance / sqrt(2)) that all points of a cell are connected, so union-find runs over
+ *  cells. Two cells are compared only while they are not yet joined, only if they are close enough to hold a
+ *  connected pair, and only through their facing extents: rows for cells side by side, columns for cells above one
+ *  another. A cell has at most size of either, so a pair of cells costs at most size^2 comparisons.
+ **/
+bool splitPoints(const PointArray *points, double distance, PointClusters *clusters)
+{
+    size_t I, cells = 0, count = 0;
+    int32_t X, Y, left = INT32_MAX, top = INT32_MAX, right = INT32_MIN, bottom = INT32_MIN;
+    int32_t size = distance < M_SQRT2 ? 1 : (int32_t)floor(distance / M_SQRT2);
+    int32_t reach = distance < 1.0 ? 0 : (int32_t)floor((distance - 1.0) / size) + 1;
+    double distanceSq = distance * distance;
+    __CellGrid grid;
+
+    for (I = 0; I < points->size; ++I)
+    {
+        left = points->p[I].x < left ? points->p[I].x : left;
+        top = points->p[I].y < top ? points->p[I].y : top;
+        right = points->p[I].x > right ? points->p[I].x : right;
+        bottom = points->p[I].y > bottom ? points->p[I].y : bottom;
+    }
+
+    uint64_t span = points->size ? ((uint64_t)right - left > (uint64_t)bottom - top ? (uint64_t)right - left : (uint64_t)bottom - top) + 1 : 1;
+    uint64_t lines = span < (uint64_t)size ? span : (uint64_t)size;
+
+    uint32_t *labels = malloc(points->size * sizeof(uint32_t) + 1);
+    uint32_t *order = malloc(points->size * sizeof(uint32_t) + 1);
+    uint32_t *starts = calloc(points->size + 2, sizeof(uint32_t));
+    uint32_t *parents = malloc(points->size * sizeof(uint32_t) + 1);
+    int32_t *cellXY = malloc(points->size * 2 * sizeof(int32_t) + 1);
+    uint32_t *ids = malloc(points->size * sizeof(uint32_t) + 1);
+    __Extent *rows = malloc(points->size * sizeof(__Extent) + 1);
+    __Extent *columns = malloc(points->size * sizeof(__Extent) + 1);
+    uint32_t *rowStarts = malloc((points->size + 1) * sizeof(uint32_t));
+    uint32_t *columnStarts = malloc((points->size + 1) * sizeof(uint32_t));
+    uint32_t *slots = lines <= SIZE_MAX / sizeof(uint32_t) ? calloc(lines, sizeof(uint32_t)) : NULL;
+
+    bool Result = __initCellGrid(&grid, points, size) && labels && order && starts && parents && cellXY && ids && rows && columns && rowStarts && columnStarts && slots;
+    for (I = 0; I < points->size && Result; ++I)
+    {
+        int32_t cellX = __cellOf(points->p[I].x, size), cellY = __cellOf(points->p[I].y, size);
+        uint32_t cell = __getCell(&grid, cellX, cellY);
+
+        if (cell == EMPTY_CELL)
+        {
+            cell = cells++;
+            __setCell(&grid, cellX, cellY, cell);
+            parents[cell] = cell;
+            cellXY[cell * 2] = cellX;
+            cellXY[cell * 2 + 1] = cellY;
+        }
+        labels[I] = cell;
+        ++starts[labels[I] + 1];
+    }
+
+    if (Result)
+    {
+        for (I = 0; I < cells; ++I)
+            starts[I + 1] += starts[I];
+
+        for (I = 0; I < points->size; ++I)
+            order[starts[labels[I]]++] = I;
+
+        for (I = cells; I > 0; --I)
+            starts[I] = starts[I - 1];
+        starts[0] = 0;
+
+        __cellExtents(points, order, starts, cellXY, cells, size, 1, top, slots, rows, rowStarts);
+        __cellExtents(points, order, starts, cellXY, cells, size, 0, left, slots, columns, columnStarts);
+
+        for (I = 0; I < cells; ++I)
+        {
+            for (Y = 0; Y <= reach; ++Y)
+            {
+                for (X = Y ? -reach : 1; X <= reach; ++X)
+                {
+                    uint32_t other = __getCell(&grid, cellXY[I * 2] + X, cellXY[I * 2 + 1] + Y);
+                    double gapX = abs(X) > 0 ? (double)(abs(X) - 1) * size + 1 : 0, gapY = Y > 0 ? (double)(Y - 1) * size + 1 : 0;
+
+                    if (other == EMPTY_CELL || gapX * gapX + gapY * gapY > distanceSq || __findRoot(parents, I) == __findRoot(parents, other))
+                        continue;
+
+                    bool joined = X ? __extentsMeet(&rows[rowStarts[I]], &rows[rowStarts[I + 1]], &rows[rowStarts[other]], &rows[rowStarts[other + 1]], X > 0, distanceSq)
+                                    : __extentsMeet(&columns[columnStarts[I]], &columns[columnStarts[I + 1]], &columns[columnStarts[other]], &columns[columnStarts[other + 1]], true, distanceSq);
+
+                    if (joined)
+                        parents[__findRoot(parents, other)] = __findRoot(parents, I);
+                }
+            }
+        }
+
+        for (I = 0; I < cells; ++I)
+            ids[I] = EMPTY_CELL;
+
+        for (I = 0; I < points->size; ++I)
+        {
+            uint32_t root = __findRoot(parents, labels[I]);
+            if (ids[root] == EMPTY_CELL)
+                ids[root] = count++;
+            labels[I] = ids[root];
+        }
+        Result = __collectClusters(points, labels, count, clusters);
+    }
+
+    __freeCellGrid(&grid);
+    free(labels);
+    free(order);
+    free(starts);
+    free(parents);
+    free(cellXY);
+    free(ids);
+    free(rows);
+    free(columns);
+    free(rowStarts);
+    free(columnStarts);
+    free(slots);
+    return Result;
+}
+
+void freePointClusters(PointClusters *clusters)
+{
+    free(clusters->clusters);
+    clusters->clusters = NULL;
+    clusters->count = 0;
+}
@@ -1,5 +1,10 @@
 #include "color.h"
 
+#include <pthread.h>
+
+static ColourTables __tables;
+static pthread_once_t __tablesOnce = PTHREAD_ONCE_INIT;
+
 static uint8_t __hsl_to_rgb_helper(float i, float j, float h)
 {
     if (h < 0.0f) h += 1.0f;
@@ -137,3 +142,33 @@ xyz lab_to_xyz(lab *px)
     res.z = (z * 108.883f);
     return res;
 }
+
+static void __buildColourTables(void)
+{
+    uint32_t I, J, K;
+    static const float matrix[3][3] = {{0.4124f, 0.3576f, 0.1805f}, {0.2126f, 0.7152f, 0.0722f}, {0.0193f, 0.1192f, 0.9505f}};
+    static const float white[3] = {95.047f, 100.000f, 108.883f};
+
+    __tables.reciprocal[0] = 0.0f;
+    for (I = 1; I < 511; ++I)
+        __tables.reciprocal[I] = 1.0f / I;
+
+    for (I = 0; I < 256; ++I)
+    {
+        float c = (I / 255.0f);
+        c = (c > 0.04045f) ? pow(((c + 0.055f) / 1.055f), 2.4f) * 100.0f : c / 12.92f;
+
+        for (J = 0; J < 3; ++J)
+            for (K = 0; K < 3; ++K)
+                __tables.xyz[J][K][I] = c * matrix[J][K] / white[J];
+    }
+
+    for (I = 0; I <= LAB_CBRT_STEPS; ++I)
+        __tables.cbrt[I] = pow(I * (LAB_CBRT_RANGE / LAB_CBRT_STEPS), (1.0f / 3.0f));
+}
+
+const ColourTables *getColourTables(void)
+{
+    pthread_once(&__tablesOnce, &__buildColourTables);
+    return &__tables;
+}
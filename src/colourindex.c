@@ -0,0 +1,274 @@
+#include "colourindex.h"
+#include "framecache.h"
+
+#define EMPTY_SLOT UINT32_MAX
+
+/** Pixels a SIMD colour scan covers in about the time of one binary search step over the index. **/
+#define COLOUR_INDEX_SCAN_PIXELS 8
+
+typedef struct
+{
+    uint32_t colour;
+    uint32_t start;
+    uint32_t count;
+} __ColourSlot;
+
+/** Positions are stored as row-major pixel indices, grouped by colour and ascending within a group. Groups are
+ *  found through an open-addressed table keyed on the 24-bit colour.
+ **/
+struct ColourIndex_t
+{
+    uint32_t width;
+    uint32_t height;
+    uint32_t *positions;
+    __ColourSlot *slots;
+    uint32_t mask;
+};
+
+static inline uint32_t __colourKey(const rgb32 *px)
+{
+    return px->r | (px->g << 8) | (px->b << 16);
+}
+
+static inline uint32_t __slotOf(uint32_t colour, uint32_t mask)
+{
+    return (colour * 2654435761u >> 8) & mask;
+}
+
+/** Sorts (colour, index) pairs by colour with two stable 12-bit counting passes, which keeps every colour's
+ *  positions in row-major order.
+ **/
+static bool __radixSort(uint64_t *pairs, uint64_t *scratch, uint32_t count)
+{
+    uint32_t I, pass, *buckets = malloc(4096 * sizeof(uint32_t));
+    if (!buckets)
+        return false;
+
+    for (pass = 0; pass < 2; ++pass)
+    {
+        uint32_t shift = 32 + pass * 12, total = 0;
+        memset(buckets, 0, 4096 * sizeof(uint32_t));
+
+        for (I = 0; I < count; ++I)
+            ++buckets[(pairs[I] >> shift) & 0xFFF];
+
+        for (I = 0; I < 4096; ++I)
+        {
+            uint32_t size = buckets[I];
+            buckets[I] = total;
+            total += size;
+        }
+
+        for (I = 0; I < count; ++I)
+            scratch[buckets[(pairs[I] >> shift) & 0xFFF]++] = pairs[I];
+
+        uint64_t *temp = pairs;
+        pairs = scratch;
+        scratch = temp;
+    }
+    free(buckets);
+    return true;
+}
+
+ColourIndex *createColourIndex(bitmap *image)
+{
+    uint32_t I, unique = 0, count = image->width * image->height;
+    ColourIndex *index = calloc(1, sizeof(ColourIndex));
+    uint64_t *pairs = malloc(count * sizeof(uint64_t) + 1);
+    uint64_t *scratch = malloc(count * sizeof(uint64_t) + 1);
+
+    if (!index || !pairs || !scratch || !(index->positions = malloc(count * sizeof(uint32_t) + 1)))
+    {
+        free(pairs);
+        free(scratch);
+        freeColourIndex(index);
+        return NULL;
+    }
+
+    for (I = 0; I < count; ++I)
+        pairs[I] = ((uint64_t)__colourKey(&image->pixels[I]) << 32) | I;
+
+    if (!__radixSort(pairs, scratch, count))
+    {
+        free(pairs);
+        free(scratch);
+        freeColourIndex(index);
+        return NULL;
+    }
+
+    index->width = image->width;
+    index->height = image->height;
+
+    for (I = 0; I < count; ++I)
+    {
+        index->positions[I] = (uint32_t)pairs[I];
+        unique += (I == 0 || (pairs[I] >> 32) != (pairs[I - 1] >> 32));
+    }
+
+    uint32_t size = 16;
+    while (size < unique * 2)
+        size <<= 1;
+
+    index->mask = size - 1;
+    if (!(index->slots = malloc(size * sizeof(__ColourSlot))))
+    {
+        free(pairs);
+        free(scratch);
+        freeColourIndex(index);
+        return NULL;
+    }
+
+    for (I = 0; I < size; ++I)
+        index->slots[I].colour = EMPTY_SLOT;
+
+    for (I = 0; I < count; )
+    {
+        uint32_t colour = pairs[I] >> 32, start = I;
+        while (I < count && (pairs[I] >> 32) == colour)
+            ++I;
+
+        uint32_t slot = __slotOf(colour, index->mask);
+        while (index->slots[slot].colour != EMPTY_SLOT)
+            slot = (slot + 1) & index->mask;
+
+        __ColourSlot entry = {colour, start, I - start};
+        index->slots[slot] = entry;
+    }
+
+    free(pairs);
+    free(scratch);
+    return index;
+}
+
+void freeColourIndex(ColourIndex *index)
+{
+    if (!index)
+        return;
+
+    free(index->positions);
+    free(index->slots);
+    free(index);
+}
+
+static void *__buildColourIndex(CTSInfo *info)
+{
+    return createColourIndex(info->targetImage);
+}
+
+static void __freeColourIndex(void *data)
+{
+    freeColourIndex(data);
+}
+
+const ColourIndex *getColourIndex(CTSInfo *info)
+{
+    return getFrameData(info, FrameColourIndexData, &__buildColourIndex, &__freeColourIndex);
+}
+
+static inline const uint32_t *__lowerBound(const uint32_t *begin, const uint32_t *end, uint64_t value)
+{
+    while (begin < end)
+    {
+        const uint32_t *middle = begin + (end - begin) / 2;
+        if (*middle < value)
+            begin = middle + 1;
+        else
+            end = middle;
+    }
+    return begin;
+}
+
+/** Narrows a colour's positions to the rows of the area. Positions outside [x1, x2) remain; see __nextRun(). **/
+static bool __rowRange(const ColourIndex *index, const rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, const uint32_t **first, const uint32_t **last)
+{
+    uint32_t key = __colourKey(colour), slot = __slotOf(key, index->mask);
+    while (index->slots[slot].colour != key)
+    {
+        if (index->slots[slot].colour == EMPTY_SLOT)
+            return false;
+        slot = (slot + 1) & index->mask;
+    }
+
+    const uint32_t *begin = &index->positions[index->slots[slot].start], *end = begin + index->slots[slot].count;
+    *first = __lowerBound(begin, end, (uint64_t)y1 * index->width + x1);
+    *last = __lowerBound(*first, end, (uint64_t)(y2 - 1) * index->width + x2);
+    return *first < *last;
+}
+
+/** Moves to the next row holding positions between first and last and returns its positions within [x1, x2) as
+ *  [start, stop). Rows are found by binary search, so a narrow area costs a few searches per row that holds the colour
+ *  rather than a walk over every position beside the area.
+ **/
+static bool __nextRun(const ColourIndex *index, const uint32_t **first, const uint32_t *last, int32_t x1, int32_t x2, const uint32_t **start, const uint32_t **stop)
+{
+    while (*first < last)
+    {
+        uint64_t row = **first / index->width;
+        *start = __lowerBound(*first, last, row * index->width + x1);
+        *stop = __lowerBound(*start, last, row * index->width + x2);
+        *first = __lowerBound(*stop, last, (row + 1) * index->width + x1);
+
+        if (*start < *stop)
+            return true;
+    }
+    return false;
+}
+
+bool colourIndexPays(const ColourIndex *index, const rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    const uint32_t *first, *last;
+    if (x2 <= x1 || y2 <= y1 || !__rowRange(index, colour, x1, y1, x2, y2, &first, &last) || (x1 == 0 && x2 == (int32_t)index->width))
+        return true;
+
+    uint64_t rows = (uint64_t)(last - first) < (uint64_t)(y2 - y1) ? (uint64_t)(last - first) : (uint64_t)(y2 - y1);
+    uint64_t steps = rows * 3 * (64 - __builtin_clzll((uint64_t)(last - first)));
+    return steps * COLOUR_INDEX_SCAN_PIXELS <= (uint64_t)(x2 - x1) * (y2 - y1);
+}
+
+uint32_t colourIndexCount(const ColourIndex *index, const rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    const uint32_t *first, *last, *start, *stop;
+    uint32_t Result = 0;
+
+    if (x2 <= x1 || y2 <= y1 || !__rowRange(index, colour, x1, y1, x2, y2, &first, &last))
+        return 0;
+
+    if (x1 == 0 && x2 == (int32_t)index->width)
+        return last - first;
+
+    while (__nextRun(index, &first, last, x1, x2, &start, &stop))
+        Result += stop - start;
+    return Result;
+}
+
+bool colourIndexFind(const ColourIndex *index, int32_t *x, int32_t *y, const rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    const uint32_t *first, *last, *start, *stop;
+    if (x2 > x1 && y2 > y1 && __rowRange(index, colour, x1, y1, x2, y2, &first, &last) && __nextRun(index, &first, last, x1, x2, &start, &stop))
+    {
+        *x = *start % index->width;
+        *y = *start / index->width;
+        return true;
+    }
+
+    *x = -1;
+    *y = -1;
+    return false;
+}
+
+bool colourIndexFindAll(const ColourIndex *index, PointArray *points, const rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    const uint32_t *first, *last, *start, *stop;
+    if (x2 <= x1 || y2 <= y1 || !__rowRange(index, colour, x1, y1, x2, y2, &first, &last))
+        return true;
+
+    while (__nextRun(index, &first, last, x1, x2, &start, &stop))
+    {
+        for (; start < stop; ++start)
+        {
+            if (!appendPoint(points, *start % index->width, *start / index->width))
+                return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,365 @@
+#include "correlation.h"
+
+#include <complex.h>
+#include <math.h>
+#include <stdatomic.h>
+
+#undef I //complex.h claims I; loops here use it as elsewhere in the library.
+
+typedef double complex fftComplex;
+
+/** The area is correlated in overlapping tiles (overlap-save) so memory stays bounded on large targets.
+ *  Tile sides are powers of two between the template size and FFT_MAX_SIZE, picked to minimise the total work.
+ **/
+#define FFT_MAX_SIZE 1024
+
+/** Windows whose masked pixels vary less than this per pixel have no defined correlation and score 0. **/
+#define FLAT_VARIANCE 1e-3
+
+typedef struct
+{
+    CTSInfo *info;
+    CorrelationMode mode;
+    uint32_t channels;
+    int32_t x1, y1;
+    uint32_t areaWidth, areaHeight;
+    uint32_t outWidth, outHeight;
+    uint32_t sizeX, sizeY;
+    uint32_t validX, validY;
+    uint32_t tilesX;
+    double count;
+    double variance;
+    fftComplex *mask;
+    fftComplex *image[3];
+    fftComplex *twiddlesX, *twiddlesY;
+    float *scores;
+    atomic_bool failed;
+} __CorrelationJob;
+
+static inline double __channel(const rgb32 *px, CorrelationMode mode, uint32_t channel)
+{
+    if (mode == CorrelateLuminance)
+        return 0.299 * px->r + 0.587 * px->g + 0.114 * px->b;
+    return channel == 0 ? px->r : channel == 1 ? px->g : px->b;
+}
+
+/** Rows of a target view hold BGR pixels, so the red and blue channels trade places. **/
+static inline double __frameChannel(const rgb32 *px, CorrelationMode mode, uint32_t channel, bool bgr)
+{
+    rgb32 colour = {px->b, px->g, px->r, px->a};
+    return __channel(bgr ? &colour : px, mode, channel);
+}
+
+static fftComplex *__twiddles(uint32_t size)
+{
+    uint32_t I;
+    fftComplex *twiddles = malloc((size / 2 + 1) * sizeof(fftComplex));
+    if (twiddles)
+    {
+        for (I = 0; I < size / 2; ++I)
+            twiddles[I] = cexp(-2.0 * M_PI * _Complex_I * I / size);
+    }
+    return twiddles;
+}
+
+/** In-place iterative radix-2 transform of a contiguous power-of-two sized sequence. The inverse is unscaled. **/
+static void __fft(fftComplex *data, uint32_t size, const fftComplex *twiddles, bool inverse)
+{
+    uint32_t I, J, K, length;
+    for (I = 1, J = 0; I < size; ++I)
+    {
+        uint32_t bit = size >> 1;
+        for (; J & bit; bit >>= 1)
+            J ^= bit;
+        J ^= bit;
+
+        if (I < J)
+        {
+            fftComplex temp = data[I];
+            data[I] = data[J];
+            data[J] = temp;
+        }
+    }
+
+    for (length = 2; length <= size; length <<= 1)
+    {
+        uint32_t half = length >> 1, step = size / length;
+        for (I = 0; I < size; I += length)
+        {
+            for (K = 0; K < half; ++K)
+            {
+                fftComplex w = inverse ? conj(twiddles[K * step]) : twiddles[K * step];
+                fftComplex u = data[I + K], v = data[I + K + half] * w;
+                data[I + K] = u + v;
+                data[I + K + half] = u - v;
+            }
+        }
+    }
+}
+
+/** Rows past rowsIn are known to be zero and rows past rowsOut are never read, so neither is transformed. **/
+static void __fft2(__CorrelationJob *job, fftComplex *data, fftComplex *column, uint32_t rowsIn, uint32_t rowsOut, bool inverse)
+{
+    uint32_t I, J;
+    if (!inverse)
+    {
+        for (I = 0; I < rowsIn; ++I)
+            __fft(&data[I * job->sizeX], job->sizeX, job->twiddlesX, false);
+    }
+
+    for (J = 0; J < job->sizeX; ++J)
+    {
+        for (I = 0; I < job->sizeY; ++I)
+            column[I] = data[I * job->sizeX + J];
+
+        __fft(column, job->sizeY, job->twiddlesY, inverse);
+
+        for (I = 0; I < job->sizeY; ++I)
+            data[I * job->sizeX + J] = column[I];
+    }
+
+    if (inverse)
+    {
+        for (I = 0; I < rowsOut; ++I)
+            __fft(&data[I * job->sizeX], job->sizeX, job->twiddlesX, true);
+    }
+}
+
+/** Every channel of the tile is packed as f + i * f^2, so one transform yields both masked window sums from a single
+ *  product with the mask spectrum, while the product with the centred image spectrum yields the cross term.
+ **/
+static void __correlateTile(void *data, uint32_t index)
+{
+    __CorrelationJob *job = data;
+    uint32_t I, J, C, area = job->sizeX * job->sizeY;
+    uint32_t tileX = (index % job->tilesX) * job->validX, tileY = (index / job->tilesX) * job->validY;
+    uint32_t rowsIn = job->areaHeight - tileY < job->sizeY ? job->areaHeight - tileY : job->sizeY;
+    uint32_t colsIn = job->areaWidth - tileX < job->sizeX ? job->areaWidth - tileX : job->sizeX;
+    uint32_t rowsOut = job->outHeight - tileY < job->validY ? job->outHeight - tileY : job->validY;
+    uint32_t colsOut = job->outWidth - tileX < job->validX ? job->outWidth - tileX : job->validX;
+    double scale = 1.0 / area;
+
+    fftComplex *tile = malloc(area * sizeof(fftComplex));
+    fftComplex *sums = malloc(area * sizeof(fftComplex));
+    fftComplex *cross = malloc(area * sizeof(fftComplex));
+    fftComplex *column = malloc(job->sizeY * sizeof(fftComplex));
+    double *numerator = calloc(rowsOut * colsOut, sizeof(double));
+    double *variance = calloc(rowsOut * colsOut, sizeof(double));
+
+    if (!tile || !sums || !cross || !column || !numerator || !variance)
+    {
+        atomic_store(&job->failed, true);
+        goto cleanup;
+    }
+
+    for (C = 0; C < job->channels; ++C)
+    {
+        memset(tile, 0, area * sizeof(fftComplex));
+        for (I = 0; I < rowsIn; ++I)
+        {
+            const rgb32 *row = &getFrameRow(job->info, job->y1 + tileY + I)[job->x1 + tileX];
+            for (J = 0; J < colsIn; ++J)
+            {
+                double value = __frameChannel(&row[J], job->mode, C, job->info->targetView.data);
+                tile[I * job->sizeX + J] = value + value * value * _Complex_I;
+            }
+        }
+
+        __fft2(job, tile, column, rowsIn, 0, false);
+        for (I = 0; I < area; ++I)
+        {
+            sums[I] = tile[I] * job->mask[I];
+            cross[I] = tile[I] * job->image[C][I];
+        }
+        __fft2(job, sums, column, 0, rowsOut, true);
+        __fft2(job, cross, column, 0, rowsOut, true);
+
+        for (I = 0; I < rowsOut; ++I)
+        {
+            for (J = 0; J < colsOut; ++J)
+            {
+                fftComplex sum = sums[I * job->sizeX + J] * scale;
+                numerator[I * colsOut + J] += creal(cross[I * job->sizeX + J]) * scale;
+                variance[I * colsOut + J] += cimag(sum) - creal(sum) * creal(sum) / job->count;
+            }
+        }
+    }
+
+    for (I = 0; I < rowsOut; ++I)
+    {
+        for (J = 0; J < colsOut; ++J)
+        {
+            double spread = variance[I * colsOut + J], score = 0.0;
+            if (spread > FLAT_VARIANCE * job->count)
+                score = numerator[I * colsOut + J] / sqrt(spread * job->variance);
+
+            job->scores[(tileY + I) * job->outWidth + tileX + J] = score > 1.0 ? 1.0f : score < -1.0 ? -1.0f : score;
+        }
+    }
+
+cleanup:
+    free(tile);
+    free(sums);
+    free(cross);
+    free(column);
+    free(numerator);
+    free(variance);
+}
+
+/** Estimates the work of covering outputs positions with tiles of size side and returns the cheapest side. **/
+static uint32_t __tileSize(uint32_t templateSize, uint32_t areaSize, uint32_t outputs)
+{
+    uint32_t side, best = 0;
+    double bestCost = INFINITY;
+
+    for (side = 1; side < templateSize; side <<= 1);
+    for (; ; side <<= 1)
+    {
+        uint32_t tiles = (outputs + (side - templateSize)) / (side - templateSize + 1);
+        double cost = (double)tiles * side * log2(side + 1);
+        if (cost < bestCost)
+        {
+            bestCost = cost;
+            best = side;
+        }
+
+        if (side >= areaSize || side >= FFT_MAX_SIZE)
+            break;
+    }
+    return best;
+}
+
+/** Prepares the conjugated spectra of the mask and of every channel of the image, centred on the masked mean. **/
+static bool __prepareImage(__CorrelationJob *job, bitmap *image)
+{
+    uint32_t I, J, C, area = job->sizeX * job->sizeY;
+    fftComplex *column = malloc(job->sizeY * sizeof(fftComplex));
+
+    job->mask = calloc(area, sizeof(fftComplex));
+    for (C = 0; C < job->channels; ++C)
+        job->image[C] = calloc(area, sizeof(fftComplex));
+
+    if (!column || !job->mask || !job->image[0] || (job->channels == 3 && (!job->image[1] || !job->image[2])))
+    {
+        free(column);
+        return false;
+    }
+
+    job->count = 0.0;
+    job->variance = 0.0;
+    for (I = 0; I < image->height; ++I)
+    {
+        for (J = 0; J < image->width; ++J)
+        {
+            if (image->pixels[I * image->width + J].a != 0)
+            {
+                job->mask[I * job->sizeX + J] = 1.0;
+                job->count += 1.0;
+            }
+        }
+    }
+
+    for (C = 0; C < job->channels && job->count > 0.0; ++C)
+    {
+        double mean = 0.0;
+        for (I = 0; I < image->height * image->width; ++I)
+        {
+            if (image->pixels[I].a != 0)
+                mean += __channel(&image->pixels[I], job->mode, C);
+        }
+        mean /= job->count;
+
+        for (I = 0; I < image->height; ++I)
+        {
+            for (J = 0; J < image->width; ++J)
+            {
+                rgb32 *pixel = &image->pixels[I * image->width + J];
+                if (pixel->a != 0)
+                {
+                    double value = __channel(pixel, job->mode, C) - mean;
+                    job->image[C][I * job->sizeX + J] = value;
+                    job->variance += value * value;
+                }
+            }
+        }
+
+        __fft2(job, job->image[C], column, image->height, 0, false);
+        for (I = 0; I < area; ++I)
+            job->image[C][I] = conj(job->image[C][I]);
+    }
+
+    __fft2(job, job->mask, column, image->height, 0, false);
+    for (I = 0; I < area; ++I)
+        job->mask[I] = conj(job->mask[I]);
+
+    free(column);
+    return job->count > 0.0 && job->variance > FLAT_VARIANCE * job->count;
+}
+
+bool correlateImage(CTSInfo *info, bitmap *imageToFind, CorrelationMode mode, float *scores, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    uint32_t C, width, height;
+    getFrameSize(info, &width, &height);
+    if (!width || !height || x2 - x1 < (int32_t)imageToFind->width || y2 - y1 < (int32_t)imageToFind->height || imageToFind->width == 0 || imageToFind->height == 0)
+        return false;
+
+    __CorrelationJob job = {info, mode, mode == CorrelateRGB ? 3 : 1, x1, y1, x2 - x1, y2 - y1};
+    job.outWidth = job.areaWidth - imageToFind->width + 1;
+    job.outHeight = job.areaHeight - imageToFind->height + 1;
+    job.sizeX = __tileSize(imageToFind->width, job.areaWidth, job.outWidth);
+    job.sizeY = __tileSize(imageToFind->height, job.areaHeight, job.outHeight);
+    job.validX = job.sizeX - imageToFind->width + 1;
+    job.validY = job.sizeY - imageToFind->height + 1;
+    job.tilesX = (job.outWidth + job.validX - 1) / job.validX;
+    job.scores = scores;
+    atomic_init(&job.failed, false);
+
+    job.twiddlesX = __twiddles(job.sizeX);
+    job.twiddlesY = __twiddles(job.sizeY);
+    bool Result = job.twiddlesX && job.twiddlesY && __prepareImage(&job, imageToFind);
+
+    if (Result)
+    {
+        uint32_t tilesY = (job.outHeight + job.validY - 1) / job.validY;
+        parallelFor(info->pool, job.tilesX * tilesY, &__correlateTile, &job);
+        Result = !atomic_load(&job.failed);
+    }
+
+    for (C = 0; C < 3; ++C)
+        free(job.image[C]);
+    free(job.mask);
+    free(job.twiddlesX);
+    free(job.twiddlesY);
+    return Result;
+}
+
+bool findImageCorrelation(CTSInfo *info, bitmap *imageToFind, CorrelationMode mode, int32_t *x, int32_t *y, float *score, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    uint32_t I, best = 0, width = x2 - x1 - imageToFind->width + 1, height = y2 - y1 - imageToFind->height + 1;
+    float *scores = NULL;
+    *x = -1;
+    *y = -1;
+
+    if (x2 - x1 < (int32_t)imageToFind->width || y2 - y1 < (int32_t)imageToFind->height || !(scores = malloc(width * height * sizeof(float))))
+        return false;
+
+    if (!correlateImage(info, imageToFind, mode, scores, x1, y1, x2, y2))
+    {
+        free(scores);
+        return false;
+    }
+
+    for (I = 1; I < width * height; ++I)
+    {
+        if (scores[I] > scores[best])
+            best = I;
+    }
+
+    *x = x1 + best % width;
+    *y = y1 + best / width;
+    if (score)
+        *score = scores[best];
+
+    free(scores);
+    return true;
+}
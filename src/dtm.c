@@ -108,9 +108,10 @@ uint32_t addDTMPoint(MDTM *dtm, MDTMPoint point)
 
 void removeDTMPoint(MDTM *dtm, uint32_t index)
 {
-    uint32_t cur;
-    for (cur = index + 1; cur < dtm->count; cur++)
-        swapDTMPoints(dtm, cur - 1, cur);
+    if (index >= dtm->count)
+        return;
+
+    memmove(&dtm->points[index], &dtm->points[index + 1], (dtm->count - index - 1) * sizeof(MDTMPoint));
     resizeDTM(dtm, dtm->count - 1);
 }
 
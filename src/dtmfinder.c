@@ -0,0 +1,607 @@
+#include "dtmfinder.h"
+#include "matchmask.h"
+
+/** Main point candidates are collected a band of rows at a time, so searches for the first match stop early and the
+ *  candidate list stays small on busy frames.
+ **/
+#define DTM_SCAN_ROWS 32
+
+/** The selectivity of each point is estimated from a grid of at most DTM_SAMPLES x DTM_SAMPLES pixels of the area. **/
+#define DTM_SAMPLES 32
+
+/** Without a frame to sample, every colour is assumed to cover this share of the pixels. **/
+#define DTM_NOMINAL_RATE 0.01
+
+typedef struct
+{
+    int32_t x, y;
+    rgb32 colour;
+    uint16_t tol;
+    int32_t size;
+    bool bad;
+    double reject;
+} __DTMPoint;
+
+/** The rotated offsets of every angle step are laid out contiguously, one array per axis, together with the
+ *  bounding box of all points (main point included) at that angle. The colours of the points are prepared once.
+ **/
+typedef struct
+{
+    const CompiledDTM *dtm;
+    uint32_t angles;
+    int32_t *x;
+    int32_t *y;
+    int32_t *bounds;
+    ColourMatcher *matcher;
+} __DTMSearch;
+
+static inline rgb32 __colourOf(Color color)
+{
+    ColorData data = {.color = color};
+    rgb32 colour = {data.bgr.r, data.bgr.g, data.bgr.b, 0};
+    return colour;
+}
+
+/** A good point rejects a position when its area holds no match and a bad point when it holds one. Assuming matches
+ *  are spread independently, the chance of an area of n pixels holding one is 1 - (1 - p)^n for a sampled rate p.
+ **/
+static void __estimateRejection(CTSInfo *info, __DTMPoint *point)
+{
+    int32_t I, J;
+    double rate = DTM_NOMINAL_RATE;
+    uint32_t width = 0, height = 0;
+    ColourMatcher *matcher = NULL;
+
+    if (info)
+        getFrameSize(info, &width, &height);
+
+    if (width && height && (matcher = createColourMatcher(info, &point->colour, &point->tol, 1)))
+    {
+        int32_t stepX = width / DTM_SAMPLES > 1 ? width / DTM_SAMPLES : 1;
+        int32_t stepY = height / DTM_SAMPLES > 1 ? height / DTM_SAMPLES : 1;
+        uint32_t hits = 0, total = 0;
+
+        for (I = 0; I < (int32_t)height; I += stepY)
+        {
+            for (J = 0; J < (int32_t)width; J += stepX, ++total)
+                hits += matchColourIn(info, matcher, 0, J, I, J + 1, I + 1);
+        }
+        rate = (hits + 0.5) / (total + 1.0);
+        freeColourMatcher(matcher);
+    }
+
+    double side = 2.0 * point->size + 1.0;
+    double covered = 1.0 - pow(1.0 - rate, side * side);
+    point->reject = point->bad ? covered : 1.0 - covered;
+}
+
+static int __compareRejection(const void *first, const void *second)
+{
+    const __DTMPoint *a = first, *b = second;
+    if (a->bad != b->bad)
+        return a->bad ? 1 : -1;
+    if (a->reject != b->reject)
+        return a->reject > b->reject ? -1 : 1;
+    return a->size - b->size;
+}
+
+/** The arrays follow the structure in the same allocation, widest elements first so each stays aligned. **/
+CompiledDTM *compileDTM(CTSInfo *info, const MDTM *dtm)
+{
+    uint32_t I;
+    if (!dtm || dtm->count < 1 || dtm->points[0].bad)
+        return NULL;
+
+    uint32_t count = dtm->count - 1;
+    __DTMPoint *points = malloc(count * sizeof(__DTMPoint) + 1);
+    CompiledDTM *compiled = malloc(sizeof(CompiledDTM) + count * (3 * sizeof(int32_t) + sizeof(rgb32) + sizeof(uint16_t)));
+
+    if (!points || !compiled)
+    {
+        free(points);
+        free(compiled);
+        return NULL;
+    }
+
+    for (I = 0; I < count; ++I)
+    {
+        const MDTMPoint *source = &dtm->points[I + 1];
+        __DTMPoint point = {source->x - dtm->points[0].x, source->y - dtm->points[0].y, __colourOf(source->color), source->tol, source->size, source->bad, 0.0};
+        __estimateRejection(info, &point);
+        points[I] = point;
+    }
+
+    qsort(points, count, sizeof(__DTMPoint), &__compareRejection);
+
+    int32_t *x = (int32_t *)(compiled + 1), *y = x + count, *size = y + count;
+    rgb32 *colours = (rgb32 *)(size + count);
+    uint16_t *tols = (uint16_t *)(colours + count);
+
+    compiled->colour = __colourOf(dtm->points[0].color);
+    compiled->tol = dtm->points[0].tol;
+    compiled->count = count;
+    compiled->goodCount = 0;
+    compiled->bounds[0] = compiled->bounds[1] = compiled->bounds[2] = compiled->bounds[3] = 0;
+
+    for (I = 0; I < count; ++I)
+    {
+        x[I] = points[I].x;
+        y[I] = points[I].y;
+        size[I] = points[I].size;
+        colours[I] = points[I].colour;
+        tols[I] = points[I].tol;
+        compiled->goodCount += !points[I].bad;
+
+        compiled->bounds[0] = x[I] < compiled->bounds[0] ? x[I] : compiled->bounds[0];
+        compiled->bounds[1] = y[I] < compiled->bounds[1] ? y[I] : compiled->bounds[1];
+        compiled->bounds[2] = x[I] > compiled->bounds[2] ? x[I] : compiled->bounds[2];
+        compiled->bounds[3] = y[I] > compiled->bounds[3] ? y[I] : compiled->bounds[3];
+    }
+
+    compiled->x = x;
+    compiled->y = y;
+    compiled->size = size;
+    compiled->colours = colours;
+    compiled->tols = tols;
+
+    free(points);
+    return compiled;
+}
+
+void freeCompiledDTM(CompiledDTM *dtm)
+{
+    free(dtm);
+}
+
+static void __freeDTMSearch(__DTMSearch *search)
+{
+    free(search->x);
+    free(search->bounds);
+    freeColourMatcher(search->matcher);
+}
+
+/** Angles are rotated once up front so each candidate only adds precomputed offsets. **/
+static bool __prepareDTMSearch(CTSInfo *info, const CompiledDTM *dtm, __DTMSearch *search, double startAngle, uint32_t angles, double step)
+{
+    uint32_t I, K, count = dtm->count;
+
+    search->dtm = dtm;
+    search->angles = angles;
+    search->x = malloc((size_t)angles * count * 2 * sizeof(int32_t) + 1);
+    search->y = search->x + (size_t)angles * count;
+    search->bounds = malloc((size_t)angles * 4 * sizeof(int32_t) + 1);
+    search->matcher = createColourMatcher(info, dtm->colours, dtm->tols, count);
+
+    if (!angles || !search->x || !search->bounds || !search->matcher)
+    {
+        __freeDTMSearch(search);
+        return false;
+    }
+
+    for (K = 0; K < angles; ++K)
+    {
+        double angle = startAngle + K * step, cosine = cos(angle), sine = sin(angle);
+        int32_t *X = &search->x[K * count], *Y = &search->y[K * count], *bounds = &search->bounds[K * 4];
+        bounds[0] = bounds[1] = bounds[2] = bounds[3] = 0;
+
+        for (I = 0; I < count; ++I)
+        {
+            X[I] = (int32_t)lround(dtm->x[I] * cosine - dtm->y[I] * sine);
+            Y[I] = (int32_t)lround(dtm->x[I] * sine + dtm->y[I] * cosine);
+
+            bounds[0] = X[I] < bounds[0] ? X[I] : bounds[0];
+            bounds[1] = Y[I] < bounds[1] ? Y[I] : bounds[1];
+            bounds[2] = X[I] > bounds[2] ? X[I] : bounds[2];
+            bounds[3] = Y[I] > bounds[3] ? Y[I] : bounds[3];
+        }
+    }
+    return true;
+}
+
+static bool __areaMatches(CTSInfo *info, const ColourMatcher *matcher, uint32_t index, int32_t size, int32_t x, int32_t y, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    int32_t left = x - size > x1 ? x - size : x1;
+    int32_t top = y - size > y1 ? y - size : y1;
+    int32_t right = x + size + 1 < x2 ? x + size + 1 : x2;
+    int32_t bottom = y + size + 1 < y2 ? y + size + 1 : y2;
+    return matchColourIn(info, matcher, index, left, top, right, bottom);
+}
+
+static bool __matchesAt(CTSInfo *info, const __DTMSearch *search, uint32_t angle, int32_t x, int32_t y, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    uint32_t I;
+    const CompiledDTM *dtm = search->dtm;
+    const int32_t *X = &search->x[angle * dtm->count], *Y = &search->y[angle * dtm->count], *bounds = &search->bounds[angle * 4];
+
+    if (x + bounds[0] < x1 || y + bounds[1] < y1 || x + bounds[2] >= x2 || y + bounds[3] >= y2)
+        return false;
+
+    for (I = 0; I < dtm->count; ++I)
+    {
+        if (__areaMatches(info, search->matcher, I, dtm->size[I], x + X[I], y + Y[I], x1, y1, x2, y2) != (I < dtm->goodCount))
+            return false;
+    }
+    return true;
+}
+
+/** Scans for main point candidates where at least one angle keeps every offset inside the area and checks each of
+ *  them at every angle in turn. With matches NULL the scan stops at the first match. Cancellation is checked between
+ *  bands of candidates.
+ **/
+static bool __scanDTM(CTSInfo *info, const __DTMSearch *search, PointArray *matches, int32_t *x, int32_t *y, double *angle, double startAngle, double step, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    uint32_t K;
+    size_t I;
+    int32_t top, bottom, left = INT32_MAX, upper = INT32_MAX, right = INT32_MIN, lower = INT32_MIN;
+    bool found = false, success = true;
+    rgb32 colour = search->dtm->colour;
+    PointArray candidates;
+
+    for (K = 0; K < search->angles; ++K)
+    {
+        const int32_t *bounds = &search->bounds[K * 4];
+        left = x1 - bounds[0] < left ? x1 - bounds[0] : left;
+        upper = y1 - bounds[1] < upper ? y1 - bounds[1] : upper;
+        right = x2 - bounds[2] > right ? x2 - bounds[2] : right;
+        lower = y2 - bounds[3] > lower ? y2 - bounds[3] : lower;
+    }
+
+    initPointArray(&candidates);
+    for (top = upper; top < lower && success && !(found && !matches) && !searchCancelled(info); top = bottom)
+    {
+        bottom = top + DTM_SCAN_ROWS < lower ? top + DTM_SCAN_ROWS : lower;
+        if (!findColoursToleranceInto(info, &candidates, &colour, left, top, right, bottom, search->dtm->tol))
+            continue;
+
+        for (I = 0; I < candidates.size && success && !(found && !matches); ++I)
+        {
+            for (K = 0; K < search->angles; ++K)
+            {
+                if (__matchesAt(info, search, K, candidates.p[I].x, candidates.p[I].y, x1, y1, x2, y2))
+                {
+                    if (matches)
+                    {
+                        success = appendPoint(matches, candidates.p[I].x, candidates.p[I].y);
+                    }
+                    else
+                    {
+                        *x = candidates.p[I].x;
+                        *y = candidates.p[I].y;
+                        if (angle)
+                            *angle = startAngle + K * step;
+                    }
+                    found = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    freePointArray(&candidates);
+    return success && found;
+}
+
+bool findCompiledDTM(CTSInfo *info, const CompiledDTM *dtm, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    return findCompiledDTMRotated(info, dtm, x, y, NULL, x1, y1, x2, y2, 0.0, 0.0, 1.0);
+}
+
+bool findCompiledDTMs(CTSInfo *info, const CompiledDTM *dtm, PointArray *points, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    __DTMSearch search;
+    if (!points || points->p)
+        return false;
+
+    initPointArray(points);
+    if (!dtm || x2 <= x1 || y2 <= y1 || !__prepareDTMSearch(info, dtm, &search, 0.0, 1, 1.0))
+        return false;
+
+    bool Result = __scanDTM(info, &search, points, NULL, NULL, NULL, 0.0, 1.0, x1, y1, x2, y2);
+    if (!Result)
+        freePointArray(points);
+
+    __freeDTMSearch(&search);
+    return Result;
+}
+
+bool findCompiledDTMRotated(CTSInfo *info, const CompiledDTM *dtm, int32_t *x, int32_t *y, double *angle, int32_t x1, int32_t y1, int32_t x2, int32_t y2, double startAngle, double endAngle, double step)
+{
+    __DTMSearch search;
+    uint32_t angles = step > 0.0 && endAngle >= startAngle ? (uint32_t)floor((endAngle - startAngle) / step + 1e-9) + 1 : 0;
+
+    *x = -1;
+    *y = -1;
+    if (!dtm || x2 <= x1 || y2 <= y1 || !__prepareDTMSearch(info, dtm, &search, startAngle, angles, step))
+        return false;
+
+    bool Result = __scanDTM(info, &search, NULL, x, y, angle, startAngle, step, x1, y1, x2, y2);
+    __freeDTMSearch(&search);
+    return Result;
+}
+
+bool findDTM(CTSInfo *info, const MDTM *dtm, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    return findDTMRotated(info, dtm, x, y, NULL, x1, y1, x2, y2, 0.0, 0.0, 1.0);
+}
+
+bool findDTMs(CTSInfo *info, const MDTM *dtm, PointArray *points, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    if (!points || points->p)
+        return false;
+
+    CompiledDTM *compiled = compileDTM(info, dtm);
+    bool Result = findCompiledDTMs(info, compiled, points, x1, y1, x2, y2);
+    freeCompiledDTM(compiled);
+    return Result;
+}
+
+bool findDTMRotated(CTSInfo *info, const MDTM *dtm, int32_t *x, int32_t *y, double *angle, int32_t x1, int32_t y1, int32_t x2, int32_t y2, double startAngle, double endAngle, double step)
+{
+    CompiledDTM *compiled = compileDTM(info, dtm);
+    bool Result = findCompiledDTMRotated(info, compiled, x, y, angle, x1, y1, x2, y2, startAngle, endAngle, step);
+    freeCompiledDTM(compiled);
+    return Result;
+}
+
+
+/** A shaped area is held as one run of pixels per row: columns [left, right] around the point on row dy. **/
+typedef struct
+{
+    int32_t dy, left, right;
+} __Span;
+
+typedef struct
+{
+    int32_t x, y;
+    rgb32 colour;
+    uint16_t tol;
+    int32_t size;
+    __Span *spans;
+    uint64_t pixels;
+} __SDTMPoint;
+
+static bool __prepareSDTMPoint(const SDTMPoint *source, const SDTMPoint *main, __SDTMPoint *point)
+{
+    int32_t I, size = (int32_t)source->size;
+    point->x = source->x - main->x;
+    point->y = source->y - main->y;
+    point->colour = __colourOf(source->color);
+    point->tol = source->tol;
+    point->size = size;
+    point->pixels = 0;
+
+    if (!(point->spans = malloc((2 * size + 1) * sizeof(__Span))))
+        return false;
+
+    for (I = -size; I <= size; ++I)
+    {
+        int32_t half = source->shape == DTMShapeCircle ? (int32_t)floor(sqrt((double)size * size - (double)I * I)) : size;
+        __Span span = {I, -half, half};
+        point->spans[I + size] = span;
+        point->pixels += 2 * half + 1;
+    }
+    return true;
+}
+
+static void __freeSDTMPoints(__SDTMPoint *points, uint32_t count)
+{
+    uint32_t I;
+    for (I = 0; points && I < count; ++I)
+        free(points[I].spans);
+    free(points);
+}
+
+static int __comparePixels(const void *first, const void *second)
+{
+    const __SDTMPoint *a = first, *b = second;
+    return a->pixels < b->pixels ? -1 : a->pixels > b->pixels;
+}
+
+static bool __spansMatch(CTSInfo *info, const ColourMatcher *matcher, const __SDTMPoint *point, int32_t x, int32_t y, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    int32_t I;
+
+    for (I = 0; I < 2 * point->size + 1; ++I)
+    {
+        const __Span *span = &point->spans[I];
+        int32_t row = y + span->dy;
+        int32_t left = x + span->left > x1 ? x + span->left : x1;
+        int32_t right = x + span->right + 1 < x2 ? x + span->right + 1 : x2;
+
+        if (row >= y1 && row < y2 && matchColourIn(info, matcher, 0, left, row, right, row + 1))
+            return true;
+    }
+    return false;
+}
+
+static bool __anyBits(const uint32_t *bits, int32_t from, int32_t to)
+{
+    while (from < to)
+    {
+        uint32_t word = bits[from >> 5] >> (from & 31);
+        int32_t taken = 32 - (from & 31);
+
+        if (taken > to - from)
+            word &= (1u << (to - from)) - 1;
+        if (word)
+            return true;
+        from += taken;
+    }
+    return false;
+}
+
+static void __setBits(uint32_t *bits, int32_t from, int32_t to)
+{
+    for (; from < to && (from & 31); ++from)
+        bits[from >> 5] |= 1u << (from & 31);
+    for (; from + 32 <= to; from += 32)
+        bits[from >> 5] = UINT32_MAX;
+    for (; from < to; ++from)
+        bits[from >> 5] |= 1u << (from & 31);
+}
+
+static bool __maskMatch(const __SDTMPoint *point, const MatchMask *mask, int32_t x, int32_t y)
+{
+    int32_t I;
+    for (I = 0; I < 2 * point->size + 1; ++I)
+    {
+        const __Span *span = &point->spans[I];
+        int32_t row = y + span->dy;
+        int32_t left = x + span->left > mask->x1 ? x + span->left : mask->x1;
+        int32_t right = x + span->right + 1 < mask->x2 ? x + span->right + 1 : mask->x2;
+
+        if (row >= mask->y1 && row < mask->y2 && __anyBits(&mask->bits[(row - mask->y1) * mask->words], left - mask->x1, right - mask->x1))
+            return true;
+    }
+    return false;
+}
+
+/** A main point with an area matches wherever its area covers a pixel of its colour, so each such pixel marks every
+ *  position whose area covers it. Shapes are symmetric, which makes those positions the pixel's own area.
+ **/
+static bool __dilateCandidates(const __SDTMPoint *main, PointArray *hits, PointArray *candidates, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    size_t H;
+    int32_t I;
+    MatchMask mask;
+    initMatchMask(&mask);
+
+    if (!resizeMatchMask(&mask, x1, y1, x2, y2))
+        return false;
+
+    for (H = 0; H < hits->size; ++H)
+    {
+        for (I = 0; I < 2 * main->size + 1; ++I)
+        {
+            const __Span *span = &main->spans[I];
+            int32_t row = hits->p[H].y + span->dy;
+            int32_t left = hits->p[H].x + span->left > x1 ? hits->p[H].x + span->left : x1;
+            int32_t right = hits->p[H].x + span->right + 1 < x2 ? hits->p[H].x + span->right + 1 : x2;
+
+            if (row >= y1 && row < y2 && left < right)
+                __setBits(&mask.bits[(size_t)(row - y1) * mask.words], left - x1, right - x1);
+        }
+    }
+
+    bool Result = matchMaskPoints(&mask, candidates);
+    freeMatchMask(&mask);
+    return Result;
+}
+
+/** Filters the candidates by one point. Each candidate's area is checked pixel by pixel unless the areas together
+ *  would cover more pixels than their bounding region, in which case the region is matched once into a mask.
+ **/
+static bool __filterCandidates(CTSInfo *info, const __SDTMPoint *point, PointArray *candidates, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    size_t I, kept = 0;
+    int32_t left = INT32_MAX, top = candidates->p[0].y + point->y - point->size;
+    int32_t right = INT32_MIN, bottom = candidates->p[candidates->size - 1].y + point->y + point->size + 1;
+    rgb32 colour = point->colour;
+    MatchMask mask;
+    initMatchMask(&mask);
+
+    for (I = 0; I < candidates->size; ++I)
+    {
+        left = candidates->p[I].x < left ? candidates->p[I].x : left;
+        right = candidates->p[I].x > right ? candidates->p[I].x : right;
+    }
+
+    left = left + point->x - point->size > x1 ? left + point->x - point->size : x1;
+    right = right + point->x + point->size + 1 < x2 ? right + point->x + point->size + 1 : x2;
+    top = top > y1 ? top : y1;
+    bottom = bottom < y2 ? bottom : y2;
+
+    bool masked = left < right && top < bottom && (uint64_t)candidates->size * point->pixels >= (uint64_t)(right - left) * (bottom - top);
+    ColourMatcher *matcher = masked ? NULL : createColourMatcher(info, &point->colour, &point->tol, 1);
+    if (masked ? !findColoursMask(info, &mask, &colour, left, top, right, bottom, point->tol) : !matcher)
+        return false;
+
+    for (I = 0; I < candidates->size; ++I)
+    {
+        int32_t x = candidates->p[I].x + point->x, y = candidates->p[I].y + point->y;
+        if (masked ? __maskMatch(point, &mask, x, y) : __spansMatch(info, matcher, point, x, y, x1, y1, x2, y2))
+            candidates->p[kept++] = candidates->p[I];
+    }
+
+    candidates->size = kept;
+    freeColourMatcher(matcher);
+    freeMatchMask(&mask);
+    return true;
+}
+
+/** Points are applied one after another to the whole candidate list, smallest areas first, so every point can pick
+ *  the cheaper way of checking the candidates that are left.
+ **/
+static bool __searchSDTM(CTSInfo *info, const SDTM *dtm, PointArray *candidates, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    uint32_t I, count = dtm ? dtm->count + 1 : 0;
+    __SDTMPoint *points = count ? calloc(count, sizeof(__SDTMPoint)) : NULL;
+    bool success = points != NULL;
+    int32_t bounds[4] = {0, 0, 0, 0};
+
+    for (I = 0; I < count && success; ++I)
+    {
+        success = __prepareSDTMPoint(I ? &dtm->points[I - 1] : &dtm->main, &dtm->main, &points[I]);
+        bounds[0] = points[I].x < bounds[0] ? points[I].x : bounds[0];
+        bounds[1] = points[I].y < bounds[1] ? points[I].y : bounds[1];
+        bounds[2] = points[I].x > bounds[2] ? points[I].x : bounds[2];
+        bounds[3] = points[I].y > bounds[3] ? points[I].y : bounds[3];
+    }
+
+    int32_t left = x1 - bounds[0], top = y1 - bounds[1], right = x2 - bounds[2], bottom = y2 - bounds[3];
+    if (!success || x2 <= x1 || y2 <= y1 || left >= right || top >= bottom)
+    {
+        __freeSDTMPoints(points, count);
+        return false;
+    }
+
+    const __SDTMPoint *main = &points[0];
+    rgb32 colour = main->colour;
+    PointArray hits;
+    initPointArray(&hits);
+
+    if (!main->size)
+    {
+        findColoursToleranceInto(info, candidates, &colour, left, top, right, bottom, main->tol);
+    }
+    else if (findColoursToleranceInto(info, &hits, &colour, left - main->size > x1 ? left - main->size : x1, top - main->size > y1 ? top - main->size : y1,
+                                      right + main->size < x2 ? right + main->size : x2, bottom + main->size < y2 ? bottom + main->size : y2, main->tol))
+    {
+        success = __dilateCandidates(main, &hits, candidates, left, top, right, bottom);
+    }
+    freePointArray(&hits);
+
+    qsort(&points[1], count - 1, sizeof(__SDTMPoint), &__comparePixels);
+    for (I = 1; I < count && success && candidates->size; ++I)
+        success = __filterCandidates(info, &points[I], candidates, x1, y1, x2, y2);
+
+    __freeSDTMPoints(points, count);
+    return success && candidates->size;
+}
+
+bool findSDTM(CTSInfo *info, const SDTM *dtm, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    PointArray candidates;
+    initPointArray(&candidates);
+
+    bool Result = __searchSDTM(info, dtm, &candidates, x1, y1, x2, y2);
+    *x = Result ? candidates.p[0].x : -1;
+    *y = Result ? candidates.p[0].y : -1;
+
+    freePointArray(&candidates);
+    return Result;
+}
+
+bool findSDTMs(CTSInfo *info, const SDTM *dtm, PointArray *points, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    if (!points || points->p)
+        return false;
+
+    initPointArray(points);
+    if (!__searchSDTM(info, dtm, points, x1, y1, x2, y2))
+    {
+        freePointArray(points);
+        return false;
+    }
+    return true;
+}
@@ -1,75 +1,763 @@
 #include "finder.h"
+#include "colourindex.h"
+#include "finderasync.h"
+#include "framecache.h"
+#include "integral.h"
+#include "simd.h"
+#include "tilebounds.h"
 
-void initPointArray(PointArray* pa)
+#include <stdatomic.h>
+
+/** Each CTS prepares the constant side of a comparison once (tolerance products, colour-space conversions)
+ *  so the per-pixel test is a plain inline expression the scan loops below can be specialised on.
+ **/
+typedef struct
+{
+    rgb32 colour;
+} __stateCTSN;
+
+typedef struct
+{
+    rgb32 colour;
+    int32_t tol;
+} __stateCTS0;
+
+typedef struct
+{
+    rgb32 colour;
+    int32_t tolSq;
+} __stateCTS1;
+
+typedef struct
+{
+    hsl colour;
+    float hueTol, satTol;
+    const ColourTables *tables;
+} __stateCTS2;
+
+typedef struct
+{
+    lab colour;
+    float tol;
+    const ColourTables *tables;
+} __stateCTS3;
+
+static inline __stateCTSN __prepareCTSN(CTSInfo *info, rgb32 *colour, uint16_t tol)
+{
+    __stateCTSN state = {*colour};
+    return state;
+}
+
+static inline bool __matchCTSN(const __stateCTSN *state, const rgb32 *px)
+{
+    return (state->colour.r == px->r) && (state->colour.g == px->g) && (state->colour.b == px->b);
+}
+
+static inline __stateCTS0 __prepareCTS0(CTSInfo *info, rgb32 *colour, uint16_t tol)
+{
+    __stateCTS0 state = {*colour, tol};
+    return state;
+}
+
+static inline bool __matchCTS0(const __stateCTS0 *state, const rgb32 *px)
+{
+    return abs(state->colour.r - px->r) <= state->tol && abs(state->colour.g - px->g) <= state->tol && abs(state->colour.b - px->b) <= state->tol;
+}
+
+static inline __stateCTS1 __prepareCTS1(CTSInfo *info, rgb32 *colour, uint16_t tol)
+{
+    __stateCTS1 state = {*colour, (int32_t)tol * tol};
+    return state;
+}
+
+static inline bool __matchCTS1(const __stateCTS1 *state, const rgb32 *px)
+{
+    int32_t R = state->colour.r - px->r, G = state->colour.g - px->g, B = state->colour.b - px->b;
+    return (R * R + G * G + B * B) <= state->tolSq;
+}
+
+static inline __stateCTS2 __prepareCTS2(CTSInfo *info, rgb32 *colour, uint16_t tol)
+{
+    const ColourTables *tables = getColourTables();
+    __stateCTS2 state = {rgb_to_hsl_lut(tables, colour), tol * info->hueMod, tol * info->satMod, tables};
+    return state;
+}
+
+static inline bool __matchCTS2(const __stateCTS2 *state, const rgb32 *px)
+{
+    hsl other = rgb_to_hsl_lut(state->tables, px);
+    return (fabsf(other.h - state->colour.h) <= state->hueTol) && (fabsf(other.s - state->colour.s) <= state->satTol);
+}
+
+static inline __stateCTS3 __prepareCTS3(CTSInfo *info, rgb32 *colour, uint16_t tol)
+{
+    const ColourTables *tables = getColourTables();
+    __stateCTS3 state = {rgb_to_lab_lut(tables, colour), ceil(sqrt((double)tol * tol)), tables};
+    return state;
+}
+
+static inline bool __matchCTS3(const __stateCTS3 *state, const rgb32 *px)
+{
+    lab other = rgb_to_lab_lut(state->tables, px);
+
+    float L = (other.l - state->colour.l);
+    float A = (other.a - state->colour.a);
+    float B = (other.b - state->colour.b);
+    return (L * L) + (A * A) + (B * B) <= state->tol;
+}
+
+#define DEFINE_CTS_COMPARATOR(CTS) \
+static bool __##CTS(void *this_ptr, rgb32 *first, rgb32 *second) \
+{ \
+    CTSInfo *info = this_ptr; \
+    __state##CTS state = __prepare##CTS(info, first, info->tol); \
+    return __match##CTS(&state, second); \
+}
+
+DEFINE_CTS_COMPARATOR(CTSN)
+DEFINE_CTS_COMPARATOR(CTS0)
+DEFINE_CTS_COMPARATOR(CTS1)
+DEFINE_CTS_COMPARATOR(CTS2)
+DEFINE_CTS_COMPARATOR(CTS3)
+
+
+/** Colour scans read the frame a row at a time through getFrameRow(), so they run in place on a TargetView as well
+ *  as on targetImage. A view holds BGR pixels: the CTS -1 to 1 kernels treat red and blue alike, so they search it
+ *  with the query colour's red and blue swapped, while the other comparisons swap each pixel as it is loaded.
+ **/
+static inline rgb32 __swapRedBlue(const rgb32 *px)
+{
+    rgb32 Result = {px->b, px->g, px->r, px->a};
+    return Result;
+}
+
+static inline rgb32 __targetColour(const CTSInfo *info, const rgb32 *colour)
 {
-    pa->p = NULL;
-    pa->size = 0;
+    return info->targetView.data ? __swapRedBlue(colour) : *colour;
 }
 
-void freePointArray(PointArray* pa)
+static inline rgb32 __loadPixel(const rgb32 *row, int32_t x, bool swap)
 {
-    free(pa->p);
-    pa->p = NULL;
-    pa->size = 0;
+    return swap ? __swapRedBlue(&row[x]) : row[x];
 }
 
-static bool __CTSN(void *this_ptr, rgb32 *first, rgb32 *second)
+/** Image searches address the frame by offsets from a position, so they need the distance between its rows. **/
+static inline uint32_t __frameStride(const CTSInfo *info)
 {
-    return (first->r == second->r) && (first->g == second->g) && (first->b == second->b); //first->color == second->color;
+    return info->targetView.data ? info->targetView.stride : info->targetImage->width;
 }
 
-static bool __CTS0(void *this_ptr, rgb32 *first, rgb32 *second)
+/** Scans that walk rows one at a time check for cancellation whenever they enter a new row of tiles. **/
+static inline bool __stopAtRow(const CTSInfo *info, int32_t y)
 {
-    uint16_t tol = ((CTSInfo *) this_ptr)->tol;
-    return abs(first->r - second->r) <= tol && abs(first->g - second->g) <= tol && abs(first->b - second->b) <= tol;
+    return y % TILE_BOUNDS_SIZE == 0 && searchCancelled(info);
+}
+
+
+/** Generates the colour scans of CTS -1, 0 and 1, which hand every row to the active SIMD kernels. **/
+#define DEFINE_SIMD_SCANS(CTS, NUM) \
+static uint32_t __count##CTS(CTSInfo *info, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance) \
+{ \
+    int I; \
+    uint32_t Result = 0; \
+    const SIMDKernels *kernels = getSIMDKernels(NUM); \
+    const rgb32 query = __targetColour(info, colour); \
+    for (I = y1; I < y2; ++I) \
+        Result += kernels->count(&getFrameRow(info, I)[x1], x2 - x1, &query, tolerance); \
+    return Result; \
+} \
+\
+static bool __find##CTS(CTSInfo *info, int32_t *x, int32_t *y, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance) \
+{ \
+    int I, J; \
+    const SIMDKernels *kernels = getSIMDKernels(NUM); \
+    const rgb32 query = __targetColour(info, colour); \
+    for (I = y1; I < y2; ++I) \
+    { \
+        if ((J = kernels->find(&getFrameRow(info, I)[x1], x2 - x1, &query, tolerance)) != -1) \
+        { \
+            *x = J + x1; \
+            *y = I; \
+            return true; \
+        } \
+    } \
+    return false; \
+} \
+\
+static bool __findAll##CTS(CTSInfo *info, PointArray *points, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance) \
+{ \
+    int I, J; \
+    bool Result = true; \
+    const SIMDKernels *kernels = getSIMDKernels(NUM); \
+    const rgb32 query = __targetColour(info, colour); \
+    uint32_t stackBits[128]; \
+    uint32_t *bits = (x2 - x1) <= 128 * 32 ? stackBits : malloc(((x2 - x1 + 31) / 32) * sizeof(uint32_t)); \
+    \
+    if (!bits) \
+        return false; \
+    \
+    for (I = y1; I < y2 && Result; ++I) \
+    { \
+        if (!kernels->mask(&getFrameRow(info, I)[x1], x2 - x1, &query, tolerance, bits)) \
+            continue; \
+        \
+        for (J = 0; J < x2 - x1 && Result; J += 32) \
+        { \
+            uint32_t word = bits[J >> 5]; \
+            for (; word && Result; word &= word - 1) \
+                Result = appendPoint(points, x1 + J + __builtin_ctz(word), I); \
+        } \
+    } \
+    \
+    if (bits != stackBits) \
+        free(bits); \
+    return Result; \
+} \
+\
+static void __mask##CTS(CTSInfo *info, uint32_t *bits, uint32_t words, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance) \
+{ \
+    int I; \
+    const SIMDKernels *kernels = getSIMDKernels(NUM); \
+    const rgb32 query = __targetColour(info, colour); \
+    for (I = y1; I < y2; ++I, bits += words) \
+        kernels->mask(&getFrameRow(info, I)[x1], x2 - x1, &query, tolerance, bits); \
+}
+
+DEFINE_SIMD_SCANS(CTSN, -1)
+DEFINE_SIMD_SCANS(CTS0, 0)
+DEFINE_SIMD_SCANS(CTS1, 1)
+
+
+/** Generates the colour scans of a CTS whose comparison has no SIMD kernel. Neighbouring pixels of a game frame
+ *  are mostly the same colour, so each scan remembers the last colour it converted and reuses that result.
+ **/
+static inline uint32_t __colourKey(const rgb32 *px)
+{
+    return px->r | (px->g << 8) | (px->b << 16);
+}
+
+#define CACHED_MATCH(CTS, state, last, lastMatch, px) \
+    (__colourKey(px) == last ? lastMatch : (last = __colourKey(px), lastMatch = __match##CTS(state, px)))
+
+#define DEFINE_COLOUR_SCANS(CTS) \
+static uint32_t __count##CTS(CTSInfo *info, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance) \
+{ \
+    int I, J; \
+    uint32_t Result = 0; \
+    uint32_t last = UINT32_MAX; \
+    bool lastMatch = false, swap = info->targetView.data; \
+    const __state##CTS state = __prepare##CTS(info, colour, tolerance); \
+    for (I = y1; I < y2; ++I) \
+    { \
+        const rgb32 *row = getFrameRow(info, I); \
+        for (J = x1; J < x2; ++J) \
+        { \
+            const rgb32 px = __loadPixel(row, J, swap); \
+            Result += CACHED_MATCH(CTS, &state, last, lastMatch, &px); \
+        } \
+    } \
+    return Result; \
+} \
+\
+static bool __find##CTS(CTSInfo *info, int32_t *x, int32_t *y, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance) \
+{ \
+    int I, J; \
+    uint32_t last = UINT32_MAX; \
+    bool lastMatch = false, swap = info->targetView.data; \
+    const __state##CTS state = __prepare##CTS(info, colour, tolerance); \
+    for (I = y1; I < y2; ++I) \
+    { \
+        const rgb32 *row = getFrameRow(info, I); \
+        for (J = x1; J < x2; ++J) \
+        { \
+            const rgb32 px = __loadPixel(row, J, swap); \
+            if (CACHED_MATCH(CTS, &state, last, lastMatch, &px)) \
+            { \
+                *x = J; \
+                *y = I; \
+                return true; \
+            } \
+        } \
+    } \
+    return false; \
+} \
+\
+static bool __findAll##CTS(CTSInfo *info, PointArray *points, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance) \
+{ \
+    int I, J; \
+    uint32_t last = UINT32_MAX; \
+    bool lastMatch = false, swap = info->targetView.data; \
+    const __state##CTS state = __prepare##CTS(info, colour, tolerance); \
+    for (I = y1; I < y2; ++I) \
+    { \
+        const rgb32 *row = getFrameRow(info, I); \
+        for (J = x1; J < x2; ++J) \
+        { \
+            const rgb32 px = __loadPixel(row, J, swap); \
+            if (CACHED_MATCH(CTS, &state, last, lastMatch, &px) && !appendPoint(points, J, I)) \
+                return false; \
+        } \
+    } \
+    return true; \
+} \
+\
+static void __mask##CTS(CTSInfo *info, uint32_t *bits, uint32_t words, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance) \
+{ \
+    int I, J; \
+    uint32_t last = UINT32_MAX; \
+    bool lastMatch = false, swap = info->targetView.data; \
+    const __state##CTS state = __prepare##CTS(info, colour, tolerance); \
+    for (I = y1; I < y2; ++I, bits += words) \
+    { \
+        const rgb32 *row = getFrameRow(info, I); \
+        memset(bits, 0, words * sizeof(uint32_t)); \
+        for (J = x1; J < x2; ++J) \
+        { \
+            const rgb32 px = __loadPixel(row, J, swap); \
+            if (CACHED_MATCH(CTS, &state, last, lastMatch, &px)) \
+                bits[(J - x1) >> 5] |= 1u << ((J - x1) & 31); \
+        } \
+    } \
 }
 
-static bool __CTS1(void *this_ptr, rgb32 *first, rgb32 *second)
+DEFINE_COLOUR_SCANS(CTS2)
+DEFINE_COLOUR_SCANS(CTS3)
+
+
+/** Necessary conditions derived from per-frame data. Each one only rejects positions where the pixel-wise comparison
+ *  is certain to fail, so they change how fast a search runs but never its result. The data is only fetched once
+ *  FILTER_LAZY positions survived the probe, so searches that end early never pay for building it.
+ **/
+#define FILTER_LAZY 1024
+
+/** tpl gives the comparison order of a template's pixels. regions is only set for the CTS whose comparisons block and
+ *  window sums can bound, and also gates the template's coarse pyramid check.
+ **/
+typedef struct
 {
-    uint16_t tol = ((CTSInfo *) this_ptr)->tol;
-    return ((first->r - second->r) * (first->r - second->r) + (first->g - second->g) * (first->g - second->g) + (first->b - second->b) * (first->b - second->b)) <= (tol * tol);
+    CTSInfo *info;
+    const Template *tpl;
+    const TemplateRegions *regions;
+    const FramePyramid *pyramid;
+    const IntegralImage *integral;
+    uint32_t survivors;
+} __ImageFilters;
+
+static void *__buildFramePyramid(CTSInfo *info)
+{
+    return createFramePyramid(info->targetImage);
 }
 
-static bool __CTS2(void *this_ptr, rgb32 *first, rgb32 *second)
+static void __freeFramePyramid(void *data)
 {
-    CTSInfo *info = this_ptr;
-    static hsl hfirst = {0}, hsecond = {0};
+    freeFramePyramid(data);
+}
 
-    if (first->r != 0 && first->g != 0 && first->b != 0)
+static inline bool __passFilters(__ImageFilters *filters, int32_t x, int32_t y, int16_t CTSNum, uint16_t tolerance)
+{
+    if (filters->survivors < FILTER_LAZY)
     {
-        hfirst = rgb_to_hsl(first);
+        if (++filters->survivors < FILTER_LAZY)
+            return true;
+
+        if (filters->regions && filters->regions->count)
+            filters->integral = getIntegralImage(filters->info);
+        if (filters->tpl && filters->regions)
+            filters->pyramid = getFrameData(filters->info, FramePyramidData, &__buildFramePyramid, &__freeFramePyramid);
     }
 
-    if (second->r != 0 && second->g != 0 && second->b != 0)
+    if (filters->integral && !matchTemplateRegions(filters->regions, filters->integral, x, y, CTSNum, tolerance))
+        return false;
+    return !filters->pyramid || matchTemplateCoarse(filters->tpl, filters->pyramid, x, y, CTSNum, tolerance);
+}
+
+/** Generates the image scan of a CTS. The template's opaque pixels are prepared once up front, in the template's
+ *  anchor order when one is given, so that every candidate position only runs the inlined comparison. Most
+ *  positions fail on their first few pixels; those that survive FILTER_PROBE of them go through the filters
+ *  before the rest is compared. On a target view the CTS -1 to 1 scans prepare the template's pixels with red and
+ *  blue swapped, while the other comparisons swap each frame pixel as it is loaded.
+ **/
+#define FILTER_PROBE 4
+
+#define DEFINE_IMAGE_SCAN(CTS, NUM) \
+static bool __findImage##CTS(CTSInfo *info, bitmap *image, __ImageFilters *filters, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance) \
+{ \
+    const Template *tpl = filters ? filters->tpl : NULL; \
+    int I, J, K, count = 0; \
+    int dX = (x2 - x1) - (image->width - 1); \
+    int dY = (y2 - y1) - (image->height - 1); \
+    uint32_t XX, YY, width = __frameStride(info); \
+    const bool swap = NUM > 1 && info->targetView.data; \
+    __state##CTS *states = malloc(image->width * image->height * sizeof(__state##CTS)); \
+    int32_t *offsets = malloc(image->width * image->height * sizeof(int32_t)); \
+    \
+    if (!states || !offsets) \
+    { \
+        free(states); \
+        free(offsets); \
+        return false; \
+    } \
+    \
+    if (tpl) \
+    { \
+        for (count = 0; count < tpl->count; ++count) \
+        { \
+            uint32_t index = tpl->order[count]; \
+            rgb32 colour = swap ? image->pixels[index] : __targetColour(info, &image->pixels[index]); \
+            states[count] = __prepare##CTS(info, &colour, tolerance); \
+            offsets[count] = (index / image->width) * width + index % image->width; \
+        } \
+    } \
+    else \
+    { \
+        for (YY = 0; YY < image->height; ++YY) \
+        { \
+            for (XX = 0; XX < image->width; ++XX) \
+            { \
+                rgb32 *pixel = &image->pixels[YY * image->width + XX]; \
+                if (pixel->a != 0) \
+                { \
+                    rgb32 colour = swap ? *pixel : __targetColour(info, pixel); \
+                    states[count] = __prepare##CTS(info, &colour, tolerance); \
+                    offsets[count++] = YY * width + XX; \
+                } \
+            } \
+        } \
+    } \
+    \
+    for (I = 0; I < dY && !__stopAtRow(info, I + y1); ++I) \
+    { \
+        const rgb32 *row = &getFrameRow(info, I + y1)[x1]; \
+        for (J = 0; J < dX; ++J) \
+        { \
+            const rgb32 *origin = &row[J]; \
+            for (K = 0; K < count; ++K) \
+            { \
+                const rgb32 px = __loadPixel(origin, offsets[K], swap); \
+                if (!__match##CTS(&states[K], &px)) \
+                    break; \
+                \
+                if (K == FILTER_PROBE && filters && !__passFilters(filters, J + x1, I + y1, NUM, tolerance)) \
+                    break; \
+            } \
+            \
+            if (K == count) \
+            { \
+                *x = J + x1; \
+                *y = I + y1; \
+                free(states); \
+                free(offsets); \
+                return true; \
+            } \
+        } \
+    } \
+    \
+    free(states); \
+    free(offsets); \
+    return false; \
+}
+
+DEFINE_IMAGE_SCAN(CTSN, -1)
+DEFINE_IMAGE_SCAN(CTS0, 0)
+DEFINE_IMAGE_SCAN(CTS1, 1)
+DEFINE_IMAGE_SCAN(CTS2, 2)
+DEFINE_IMAGE_SCAN(CTS3, 3)
+
+
+/** Generates the area test of a colour matcher, which runs the inlined comparison of a state prepared up front. Areas
+ *  are small, so every CTS walks them pixel by pixel.
+ **/
+typedef union
+{
+    __stateCTSN CTSN;
+    __stateCTS0 CTS0;
+    __stateCTS1 CTS1;
+    __stateCTS2 CTS2;
+    __stateCTS3 CTS3;
+} __stateAny;
+
+#define DEFINE_AREA_MATCH(CTS) \
+static void __prepareAny##CTS(CTSInfo *info, rgb32 *colour, uint16_t tolerance, __stateAny *state) \
+{ \
+    state->CTS = __prepare##CTS(info, colour, tolerance); \
+} \
+\
+static bool __matchAny##CTS(const CTSInfo *info, const __stateAny *state, int32_t x1, int32_t y1, int32_t x2, int32_t y2) \
+{ \
+    int I, J; \
+    bool swap = info->targetView.data; \
+    for (I = y1; I < y2; ++I) \
+    { \
+        const rgb32 *row = getFrameRow(info, I); \
+        for (J = x1; J < x2; ++J) \
+        { \
+            const rgb32 px = __loadPixel(row, J, swap); \
+            if (__match##CTS(&state->CTS, &px)) \
+                return true; \
+        } \
+    } \
+    return false; \
+}
+
+DEFINE_AREA_MATCH(CTSN)
+DEFINE_AREA_MATCH(CTS0)
+DEFINE_AREA_MATCH(CTS1)
+DEFINE_AREA_MATCH(CTS2)
+DEFINE_AREA_MATCH(CTS3)
+
+struct ColourMatcher_t
+{
+    bool (*match)(const CTSInfo *info, const __stateAny *state, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+    uint32_t count;
+    __stateAny states[];
+};
+
+
+struct CTSKernels_t
+{
+    uint32_t (*count)(CTSInfo *info, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+    bool (*find)(CTSInfo *info, int32_t *x, int32_t *y, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+    bool (*findAll)(CTSInfo *info, PointArray *points, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+    void (*mask)(CTSInfo *info, uint32_t *bits, uint32_t words, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+    bool (*findImage)(CTSInfo *info, bitmap *image, __ImageFilters *filters, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance);
+    void (*prepareAny)(CTSInfo *info, rgb32 *colour, uint16_t tolerance, __stateAny *state);
+    bool (*matchAny)(const CTSInfo *info, const __stateAny *state, int32_t x1, int32_t y1, int32_t x2, int32_t y2);
+};
+
+#define KERNEL_TABLE(CTS) {&__count##CTS, &__find##CTS, &__findAll##CTS, &__mask##CTS, &__findImage##CTS, &__prepareAny##CTS, &__matchAny##CTS}
+
+/** Indexed by CTSNum + 1. **/
+static const CTSKernels __kernels[5] = {KERNEL_TABLE(CTSN), KERNEL_TABLE(CTS0), KERNEL_TABLE(CTS1), KERNEL_TABLE(CTS2), KERNEL_TABLE(CTS3)};
+
+static const CTSKernels *__kernelsFor(int16_t CTSNum)
+{
+    return &__kernels[(CTSNum < -1 || CTSNum > 3 ? 1 : CTSNum) + 1];
+}
+
+
+/** Searches smaller than this are not worth waking the pool for. Larger ones are cut into a few row bands
+ *  per thread so that uneven bands still balance out.
+ **/
+#define PARALLEL_MIN_PIXELS (256 * 256)
+#define BANDS_PER_THREAD 4
+
+typedef struct
+{
+    CTSInfo *info;
+    rgb32 *colour;
+    int32_t x1, y1, x2, y2;
+    uint16_t tolerance;
+    uint32_t bands;
+    uint32_t *counts;
+    PointArray *points;
+    bool *results;
+    const TileQuery *query;
+    atomic_uint_fast64_t first;
+} __BandJob;
+
+/** With tile bounds only the runs of tiles that may hold a match are handed to the kernels. The rows of a tile row
+ *  share their runs, so areas are walked one tile row at a time. Without them, each tile row is handed over whole.
+ *  Cancellation is checked between tile rows.
+ **/
+static inline int32_t __tileRowEnd(int32_t y, int32_t y2)
+{
+    int32_t end = (y / TILE_BOUNDS_SIZE + 1) * TILE_BOUNDS_SIZE;
+    return end < y2 ? end : y2;
+}
+
+static uint32_t __countArea(CTSInfo *info, const TileQuery *query, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    int32_t I, next, runs[2 * ((x2 - x1) / TILE_BOUNDS_SIZE + 2)];
+    uint32_t R, count, Result = 0;
+
+    for (I = y1; I < y2 && !searchCancelled(info); I = next)
     {
-        hsecond = rgb_to_hsl(second);
+        next = __tileRowEnd(I, y2);
+        if (!query)
+        {
+            Result += info->kernels->count(info, colour, x1, I, x2, next, tolerance);
+            continue;
+        }
+
+        count = tileQueryRuns(query, I, x1, x2, runs);
+        for (R = 0; R < count; ++R)
+            Result += info->kernels->count(info, colour, runs[R * 2], I, runs[R * 2 + 1], next, tolerance);
     }
+    return Result;
+}
+
+static bool __findArea(CTSInfo *info, const TileQuery *query, int32_t *x, int32_t *y, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    int32_t I, J, next, runs[2 * ((x2 - x1) / TILE_BOUNDS_SIZE + 2)];
+    uint32_t R, count;
 
-    return (fabs(hsecond.h - hfirst.h) <= (info->tol * info->hueMod)) && (fabs(hsecond.s - hfirst.s) <= (info->tol * info->satMod));
+    for (I = y1; I < y2 && !searchCancelled(info); I = next)
+    {
+        next = __tileRowEnd(I, y2);
+        if (!query)
+        {
+            if (info->kernels->find(info, x, y, colour, x1, I, x2, next, tolerance))
+                return true;
+            continue;
+        }
+
+        count = tileQueryRuns(query, I, x1, x2, runs);
+        for (J = I; J < next && count; ++J)
+        {
+            for (R = 0; R < count; ++R)
+            {
+                if (info->kernels->find(info, x, y, colour, runs[R * 2], J, runs[R * 2 + 1], J + 1, tolerance))
+                    return true;
+            }
+        }
+    }
+    return false;
 }
 
-static bool __CTS3(void *this_ptr, rgb32 *first, rgb32 *second)
+static bool __findAllArea(CTSInfo *info, const TileQuery *query, PointArray *points, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
 {
-    CTSInfo *info = this_ptr;
-    static lab lfirst = {0}, lsecond = {0};
+    int32_t I, J, next, runs[2 * ((x2 - x1) / TILE_BOUNDS_SIZE + 2)];
+    uint32_t R, count;
 
-    if (first->r != 0 && first->g != 0 && first->b != 0)
+    for (I = y1; I < y2 && !searchCancelled(info); I = next)
     {
-        xyz temp = rgb_to_xyz(first);
-        lfirst = xyz_to_lab(&temp);
+        next = __tileRowEnd(I, y2);
+        if (!query)
+        {
+            if (!info->kernels->findAll(info, points, colour, x1, I, x2, next, tolerance))
+                return false;
+            continue;
+        }
+
+        count = tileQueryRuns(query, I, x1, x2, runs);
+        for (J = I; J < next && count; ++J)
+        {
+            for (R = 0; R < count; ++R)
+            {
+                if (!info->kernels->findAll(info, points, colour, runs[R * 2], J, runs[R * 2 + 1], J + 1, tolerance))
+                    return false;
+            }
+        }
     }
+    return !searchCancelled(info);
+}
+
+static const TileQuery *__tileQueryFor(CTSInfo *info, TileQuery *query, rgb32 *colour, uint16_t tolerance)
+{
+    if (!info->tileBounds || info->CTSNum > 1 || info->targetView.data)
+        return NULL;
+    return prepareTileQuery(query, getTileBounds(info), info->CTSNum, colour, tolerance) ? query : NULL;
+}
+
+static uint32_t __bandCount(CTSInfo *info, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    uint32_t threads = threadPoolSize(info->pool);
+    uint32_t rows = y2 - y1;
+
+    if (threads < 2 || (uint64_t)(x2 - x1) * rows < PARALLEL_MIN_PIXELS)
+        return 1;
+    return rows < threads * BANDS_PER_THREAD ? rows : threads * BANDS_PER_THREAD;
+}
 
-    if (second->r != 0 && second->g != 0 && second->b != 0)
+static void __bandRange(int32_t y1, int32_t y2, uint32_t bands, uint32_t band, int32_t *top, int32_t *bottom)
+{
+    uint64_t rows = y2 - y1;
+    *top = y1 + (int32_t)(rows * band / bands);
+    *bottom = y1 + (int32_t)(rows * (band + 1) / bands);
+}
+
+static void __bandRows(const __BandJob *job, uint32_t band, int32_t *top, int32_t *bottom)
+{
+    __bandRange(job->y1, job->y2, job->bands, band, top, bottom);
+}
+
+static void __countBand(void *data, uint32_t band)
+{
+    __BandJob *job = data;
+    int32_t top, bottom;
+    __bandRows(job, band, &top, &bottom);
+    job->counts[band] = __countArea(job->info, job->query, job->colour, job->x1, top, job->x2, bottom, job->tolerance);
+}
+
+/** Bands publish the row-major index of their first hit. A band gives up as soon as an earlier row already holds
+ *  a hit, so the lowest published index is always the serial scan's answer.
+ **/
+static void __findBand(void *data, uint32_t band)
+{
+    __BandJob *job = data;
+    int32_t I, x, y, next, top, bottom;
+    uint64_t width = job->x2 - job->x1;
+    __bandRows(job, band, &top, &bottom);
+
+    for (I = top; I < bottom; I = next)
     {
-        xyz temp = rgb_to_xyz(second);
-        lsecond = xyz_to_lab(&temp);
+        uint_fast64_t best = atomic_load_explicit(&job->first, memory_order_relaxed);
+        if (best < (I - job->y1) * width)
+            return;
+
+        next = job->query ? __tileRowEnd(I, bottom) : I + 1;
+        if (__findArea(job->info, job->query, &x, &y, job->colour, job->x1, I, job->x2, next, job->tolerance))
+        {
+            uint_fast64_t index = (y - job->y1) * width + (x - job->x1);
+            while (index < best && !atomic_compare_exchange_weak(&job->first, &best, index));
+            return;
+        }
     }
+}
 
-    double L = (lsecond.l - lfirst.l);
-    double A = (lsecond.a - lfirst.a);
-    double B = (lsecond.b - lfirst.b);
+static void __findAllBand(void *data, uint32_t band)
+{
+    __BandJob *job = data;
+    int32_t top, bottom;
+    __bandRows(job, band, &top, &bottom);
+    job->results[band] = __findAllArea(job->info, job->query, &job->points[band], job->colour, job->x1, top, job->x2, bottom, job->tolerance);
+}
+
+typedef struct
+{
+    CTSInfo *info;
+    const ColourQuery *queries;
+    uint32_t count;
+    int32_t x1, y1, x2, y2;
+    uint32_t bands;
+    uint32_t *counts;
+    PointArray *points;
+    bool *results;
+} __MultiJob;
 
-    return (L * L) + (A * A) + (B * B) <= ceil(sqrt(info->tol * info->tol));
+/** Runs every query over one row before moving to the next, so each row is fetched from memory once and stays
+ *  in cache while the remaining queries scan it.
+ **/
+static void __multiBand(void *data, uint32_t band)
+{
+    __MultiJob *job = data;
+    int32_t I, top, bottom;
+    uint32_t Q;
+    __bandRange(job->y1, job->y2, job->bands, band, &top, &bottom);
+    job->results[band] = true;
+
+    for (I = top; I < bottom && !__stopAtRow(job->info, I); ++I)
+    {
+        for (Q = 0; Q < job->count; ++Q)
+        {
+            const ColourQuery *query = &job->queries[Q];
+            const CTSKernels *kernels = __kernelsFor(query->CTSNum);
+            rgb32 colour = query->colour;
+
+            if (job->points)
+            {
+                if (!kernels->findAll(job->info, &job->points[band * job->count + Q], &colour, job->x1, I, job->x2, I + 1, query->tol))
+                {
+                    job->results[band] = false;
+                    return;
+                }
+            }
+            else
+            {
+                job->counts[band * job->count + Q] += kernels->count(job->info, &colour, job->x1, I, job->x2, I + 1, query->tol);
+            }
+        }
+    }
 }
 
 void setCTS(CTSInfo *info, int16_t CTSNum)
@@ -82,35 +770,61 @@ void setCTS(CTSInfo *info, int16_t CTSNum)
         case -1:
             info->CTSNum = -1;
             info->ctsFuncPtr = &__CTSN;
+            info->kernels = __kernelsFor(-1);
             break;
 
         case 0:
             info->CTSNum = 0;
             info->ctsFuncPtr = &__CTS0;
+            info->kernels = __kernelsFor(0);
             break;
 
         case 1:
             info->CTSNum = 1;
             info->ctsFuncPtr = &__CTS1;
+            info->kernels = __kernelsFor(1);
             break;
 
         case 2:
             info->CTSNum = 2;
             info->ctsFuncPtr = &__CTS2;
+            info->kernels = __kernelsFor(2);
             break;
 
         case 3:
             info->CTSNum = 3;
             info->ctsFuncPtr = &__CTS3;
+            info->kernels = __kernelsFor(3);
             break;
 
         default:
             info->CTSNum = 1;
             info->ctsFuncPtr = &__CTS1;
+            info->kernels = __kernelsFor(1);
             break;
     }
 }
 
+bool initFinder(Finder *finder, uint32_t threads)
+{
+    defaultCTS(&finder->info);
+    finder->pool = threads == 1 ? NULL : createThreadPool(threads);
+    finder->info.pool = finder->pool;
+    finder->executor = NULL;
+    return threads == 1 || finder->pool;
+}
+
+void freeFinder(Finder *finder)
+{
+    freeFinderExecutor(finder);
+    freeThreadPool(finder->pool);
+    finder->pool = NULL;
+    finder->info.pool = NULL;
+    finder->info.targetImage = NULL;
+    clearTargetView(&finder->info);
+    freeCTS(&finder->info);
+}
+
 void defaultCTS(CTSInfo *info)
 {
     if (info)
@@ -121,15 +835,81 @@ void defaultCTS(CTSInfo *info)
         info->satMod = 0.2f;
         info->targetImage = NULL;
         info->ctsFuncPtr = &__CTS1;
+        info->kernels = __kernelsFor(1);
+        info->pool = NULL;
+        info->countFirst = false;
+        info->cache = NULL;
+        info->frame = 0;
+        info->colourIndex = false;
+        info->tileBounds = false;
+        info->windowSums = false;
+        info->cancel = NULL;
+        clearTargetView(info);
     }
 }
 
+void freeCTS(CTSInfo *info)
+{
+    if (info)
+        freeFrameCache(info);
+}
+
+void setTargetImage(CTSInfo *info, bitmap *image)
+{
+    info->targetImage = image;
+    ++info->frame;
+}
+
+void setTargetView(CTSInfo *info, TargetData data, uint32_t width, uint32_t height)
+{
+    ++info->frame;
+    info->targetView.data = data.data;
+    info->targetView.width = width;
+    info->targetView.height = height;
+    info->targetView.stride = width + data.incData;
+}
+
+void clearTargetView(CTSInfo *info)
+{
+    info->targetView.data = NULL;
+    info->targetView.width = 0;
+    info->targetView.height = 0;
+    info->targetView.stride = 0;
+}
+
 bool similarColours(CTSInfo *info, rgb32 *first, rgb32 *second, uint16_t tolerance)
 {
     info->tol = tolerance;
     return (*info->ctsFuncPtr)(info, first, second); //return ((first->r - second->r) * (first->r - second->r) + (first->g - second->g) * (first->g - second->g) + (first->b - second->b) * (first->b - second->b)) <= (tolerance * tolerance);
 }
 
+ColourMatcher *createColourMatcher(CTSInfo *info, const rgb32 *colours, const uint16_t *tolerances, uint32_t count)
+{
+    uint32_t I;
+    ColourMatcher *matcher = malloc(sizeof(ColourMatcher) + count * sizeof(__stateAny));
+    if (!matcher)
+        return NULL;
+
+    matcher->match = info->kernels->matchAny;
+    matcher->count = count;
+    for (I = 0; I < count; ++I)
+    {
+        rgb32 colour = colours[I];
+        info->kernels->prepareAny(info, &colour, tolerances[I], &matcher->states[I]);
+    }
+    return matcher;
+}
+
+bool matchColourIn(const CTSInfo *info, const ColourMatcher *matcher, uint32_t index, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    return matcher->match(info, &matcher->states[index], x1, y1, x2, y2);
+}
+
+void freeColourMatcher(ColourMatcher *matcher)
+{
+    free(matcher);
+}
+
 uint32_t countColour(CTSInfo *info, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
 {
     int16_t temp = info->CTSNum;
@@ -139,22 +919,40 @@ uint32_t countColour(CTSInfo *info, rgb32 *colour, int32_t x1, int32_t y1, int32
     return Res;
 }
 
+/** The index is built on the first exact query of a frame and answers further ones in time proportional to the rows
+ *  holding the colour. Without it, when it cannot be built, or when the area is cheaper to scan, queries scan as usual.
+ **/
+static const ColourIndex *__colourIndexFor(CTSInfo *info, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    const ColourIndex *index = info->colourIndex && info->CTSNum == -1 && !info->targetView.data ? getColourIndex(info) : NULL;
+    return index && colourIndexPays(index, colour, x1, y1, x2, y2) ? index : NULL;
+}
+
 uint32_t countColourTolerance(CTSInfo *info, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
 {
-    int I, J;;
-    uint32_t Result = 0;
     info->tol = tolerance;
 
-    for (I = y1; I < y2; ++I)
-    {
-        for (J = x1; J < x2; ++J)
-        {
-            if ((*info->ctsFuncPtr)(info, colour, &info->targetImage->pixels[I * info->targetImage->width + J]))
-            {
-                ++Result;
-            }
-        }
-    }
+    if (x2 <= x1 || y2 <= y1)
+        return 0;
+
+    const ColourIndex *index = __colourIndexFor(info, colour, x1, y1, x2, y2);
+    if (index)
+        return colourIndexCount(index, colour, x1, y1, x2, y2);
+
+    TileQuery tiles;
+    const TileQuery *query = __tileQueryFor(info, &tiles, colour, tolerance);
+    uint32_t I, Result = 0;
+    uint32_t bands = __bandCount(info, x1, y1, x2, y2);
+    uint32_t counts[bands];
+    __BandJob job = {info, colour, x1, y1, x2, y2, tolerance, bands, counts, NULL, NULL, query};
+
+    if (bands == 1)
+        return __countArea(info, query, colour, x1, y1, x2, y2, tolerance);
+
+    parallelFor(info->pool, bands, &__countBand, &job);
+
+    for (I = 0; I < bands; ++I)
+        Result += counts[I];
     return Result;
 }
 
@@ -169,19 +967,39 @@ bool findColour(CTSInfo *info, int32_t *x, int32_t *y, rgb32 *colour, int32_t x1
 
 bool findColourTolerance(CTSInfo *info, int32_t *x, int32_t *y, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
 {
-    int I, J;
     info->tol = tolerance;
 
-    for (I = y1; I < y2; ++I)
+    if (x2 <= x1 || y2 <= y1)
     {
-        for (J = x1; J < x2; ++J)
+        *x = -1;
+        *y = -1;
+        return false;
+    }
+
+    const ColourIndex *index = __colourIndexFor(info, colour, x1, y1, x2, y2);
+    if (index)
+        return colourIndexFind(index, x, y, colour, x1, y1, x2, y2);
+
+    TileQuery tiles;
+    const TileQuery *query = __tileQueryFor(info, &tiles, colour, tolerance);
+    uint32_t bands = __bandCount(info, x1, y1, x2, y2);
+    if (bands == 1)
+    {
+        if (__findArea(info, query, x, y, colour, x1, y1, x2, y2, tolerance))
+            return true;
+    }
+    else
+    {
+        __BandJob job = {info, colour, x1, y1, x2, y2, tolerance, bands, NULL, NULL, NULL, query};
+        atomic_init(&job.first, UINT_FAST64_MAX);
+        parallelFor(info->pool, bands, &__findBand, &job);
+
+        uint_fast64_t first = atomic_load(&job.first);
+        if (first != UINT_FAST64_MAX)
         {
-            if ((*info->ctsFuncPtr)(info, colour, &info->targetImage->pixels[I * info->targetImage->width + J]))
-            {
-                *x = J;
-                *y = I;
-                return true;
-            }
+            *x = x1 + (int32_t)(first % (x2 - x1));
+            *y = y1 + (int32_t)(first / (x2 - x1));
+            return true;
         }
     }
 
@@ -199,45 +1017,274 @@ bool findColours(CTSInfo *info, PointArray *points, rgb32 *colour, int32_t x1, i
     return Result;
 }
 
-bool findColoursTolerance(CTSInfo *info, PointArray *points, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+/** Fills an empty PointArray in row-major order. With countFirst the matches of every band are counted up front so
+ *  the result is sized once and each band fills its own fixed slice in place. A frame that changes between the passes
+ *  can make a band find more or fewer matches than it counted; the slices are then dropped and the matches collected
+ *  again as without countFirst, where bands collect into their own arrays which are appended in band order.
+ **/
+static bool __findColours(CTSInfo *info, PointArray *points, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    const ColourIndex *index = __colourIndexFor(info, colour, x1, y1, x2, y2);
+    if (index)
+        return colourIndexFindAll(index, points, colour, x1, y1, x2, y2);
+
+    TileQuery tiles;
+    const TileQuery *query = __tileQueryFor(info, &tiles, colour, tolerance);
+    uint32_t I, bands = __bandCount(info, x1, y1, x2, y2);
+    uint32_t counts[bands];
+    bool results[bands];
+    PointArray partial[bands];
+    __BandJob job = {info, colour, x1, y1, x2, y2, tolerance, bands, counts, partial, results, query};
+    size_t total = 0;
+    bool success = true;
+
+    if (info->countFirst)
+    {
+        if (bands == 1)
+            counts[0] = __countArea(info, query, colour, x1, y1, x2, y2, tolerance);
+        else
+            parallelFor(info->pool, bands, &__countBand, &job);
+
+        for (I = 0; I < bands; ++I)
+            total += counts[I];
+
+        if (!total)
+            return true;
+
+        if (!reservePointArray(points, total))
+            return false;
+
+        for (I = 0, total = 0; I < bands; total += counts[I++])
+            initFixedPointArray(&partial[I], &points->p[total], counts[I]);
+
+        if (bands == 1)
+            __findAllBand(&job, 0);
+        else
+            parallelFor(info->pool, bands, &__findAllBand, &job);
+
+        for (I = 0; I < bands; ++I)
+            success = success && results[I] && partial[I].size == counts[I];
+
+        if (success)
+        {
+            points->size = total;
+            return true;
+        }
+
+        if (searchCancelled(info))
+            return false;
+    }
+
+    if (bands == 1)
+        return __findAllArea(info, query, points, colour, x1, y1, x2, y2, tolerance);
+
+    for (I = 0; I < bands; ++I)
+        initPointArray(&partial[I]);
+
+    parallelFor(info->pool, bands, &__findAllBand, &job);
+
+    for (I = 0, success = true; I < bands; ++I)
+    {
+        success = success && results[I] && appendPoints(points, partial[I].p, partial[I].size);
+        freePointArray(&partial[I]);
+    }
+    return success;
+}
+
+bool findColoursTolerance(CTSInfo *info, PointArray *points, rgb32* colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
 {
     if (!points || points->p)
         return false;
 
-    int I, J;
-    points->p = NULL;
-    points->size = 0;
+    initPointArray(points);
     info->tol = tolerance;
 
-    for (I = y1; I < y2; ++I)
+    if (x2 <= x1 || y2 <= y1)
+        return false;
+
+    if (!__findColours(info, points, colour, x1, y1, x2, y2, tolerance))
     {
-        for (J = x1; J < x2; ++J)
-        {
-            if ((*info->ctsFuncPtr)(info, colour, &info->targetImage->pixels[I * info->targetImage->width + J]))
-            {
-                Point *loc = realloc(points->p, sizeof(Point) * (points->size + 1));
-                if (loc)
-                {
-                    loc[points->size].x = I;
-                    loc[points->size].y = J;
+        freePointArray(points);
+        return false;
+    }
+    return points->size;
+}
 
-                    points->p = loc;
-                    ++points->size;
-                    continue;
-                }
+bool findColoursInto(CTSInfo *info, PointArray *points, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    int16_t temp = info->CTSNum;
+    setCTS(info, -1);
+    bool Result = findColoursToleranceInto(info, points, colour, x1, y1, x2, y2, 0);
+    setCTS(info, temp);
+    return Result;
+}
+
+bool findColoursToleranceInto(CTSInfo *info, PointArray *points, rgb32* colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    if (!points)
+        return false;
+
+    clearPointArray(points);
+    info->tol = tolerance;
+
+    if (x2 <= x1 || y2 <= y1)
+        return false;
+
+    if (!__findColours(info, points, colour, x1, y1, x2, y2, tolerance))
+    {
+        clearPointArray(points);
+        return false;
+    }
+    return points->size;
+}
+
+void maskColoursTolerance(CTSInfo *info, uint32_t *bits, uint32_t words, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    if (x2 > x1 && y2 > y1)
+        info->kernels->mask(info, bits, words, colour, x1, y1, x2, y2, tolerance);
+}
+
+static inline uint64_t __distanceSq(int32_t x, int32_t y, int32_t originX, int32_t originY)
+{
+    int64_t dX = (int64_t)x - originX, dY = (int64_t)y - originY;
+    return dX * dX + dY * dY;
+}
+
+/** Scans the square ring at Chebyshev distance ring around the origin, clipped to the area, as up to four segments. **/
+static bool __findRing(CTSInfo *info, PointArray *points, rgb32 *colour, int32_t originX, int32_t originY, int32_t ring, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    int32_t left = originX - ring < x1 ? x1 : originX - ring, right = originX + ring + 1 > x2 ? x2 : originX + ring + 1;
+    int32_t top = originY - ring + 1 < y1 ? y1 : originY - ring + 1, bottom = originY + ring > y2 ? y2 : originY + ring;
+    bool Result = true;
+
+    if (left < right && originY - ring >= y1 && originY - ring < y2)
+        Result = info->kernels->findAll(info, points, colour, left, originY - ring, right, originY - ring + 1, tolerance);
+
+    if (ring == 0)
+        return Result;
+
+    if (Result && top < bottom && originX - ring >= x1 && originX - ring < x2)
+        Result = info->kernels->findAll(info, points, colour, originX - ring, top, originX - ring + 1, bottom, tolerance);
+
+    if (Result && top < bottom && originX + ring >= x1 && originX + ring < x2)
+        Result = info->kernels->findAll(info, points, colour, originX + ring, top, originX + ring + 1, bottom, tolerance);
 
-                free(points->p);
-                points->p = NULL;
-                points->size = 0;
+    if (Result && left < right && originY + ring >= y1 && originY + ring < y2)
+        Result = info->kernels->findAll(info, points, colour, left, originY + ring, right, originY + ring + 1, tolerance);
+
+    return Result;
+}
+
+bool findColourSpiral(CTSInfo *info, int32_t *x, int32_t *y, rgb32 *colour, int32_t originX, int32_t originY, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    int16_t temp = info->CTSNum;
+    setCTS(info, -1);
+    bool Res = findColourSpiralTolerance(info, x, y, colour, originX, originY, x1, y1, x2, y2, 0);
+    setCTS(info, temp);
+    return Res;
+}
+
+/** Rings are scanned outwards until one holds a match. A match on ring d can lie up to d * sqrt(2) away, so the
+ *  rings that could still hold a closer match are scanned as well before the closest one is returned.
+ **/
+bool findColourSpiralTolerance(CTSInfo *info, int32_t *x, int32_t *y, rgb32 *colour, int32_t originX, int32_t originY, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    int32_t ring, last = 0;
+    size_t I;
+    uint64_t best = UINT64_MAX;
+    PointArray points;
+
+    info->tol = tolerance;
+    *x = -1;
+    *y = -1;
+
+    if (x2 <= x1 || y2 <= y1)
+        return false;
+
+    int32_t extents[4] = {originX - x1, x2 - 1 - originX, originY - y1, y2 - 1 - originY};
+    for (I = 0; I < 4; ++I)
+        last = abs(extents[I]) > last ? abs(extents[I]) : last;
+
+    initPointArray(&points);
+    for (ring = 0; ring <= last && (uint64_t)ring * ring <= best && !searchCancelled(info); ++ring)
+    {
+        clearPointArray(&points);
+        if (!__findRing(info, &points, colour, originX, originY, ring, x1, y1, x2, y2, tolerance))
+            break;
+
+        for (I = 0; I < points.size; ++I)
+        {
+            uint64_t distance = __distanceSq(points.p[I].x, points.p[I].y, originX, originY);
+            if (distance < best || (distance == best && (points.p[I].y < *y || (points.p[I].y == *y && points.p[I].x < *x))))
+            {
+                best = distance;
+                *x = points.p[I].x;
+                *y = points.p[I].y;
             }
         }
     }
-    return points->p;
+
+    freePointArray(&points);
+    return best != UINT64_MAX;
+}
+
+typedef struct
+{
+    uint64_t distance;
+    Point point;
+} __SpiralPoint;
+
+static int __compareSpiral(const void *first, const void *second)
+{
+    const __SpiralPoint *a = first, *b = second;
+    if (a->distance != b->distance)
+        return a->distance < b->distance ? -1 : 1;
+    if (a->point.y != b->point.y)
+        return a->point.y < b->point.y ? -1 : 1;
+    return a->point.x < b->point.x ? -1 : (a->point.x > b->point.x);
+}
+
+bool findColoursSpiral(CTSInfo *info, PointArray *points, rgb32 *colour, int32_t originX, int32_t originY, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    int16_t temp = info->CTSNum;
+    setCTS(info, -1);
+    bool Result = findColoursSpiralTolerance(info, points, colour, originX, originY, x1, y1, x2, y2, 0);
+    setCTS(info, temp);
+    return Result;
+}
+
+bool findColoursSpiralTolerance(CTSInfo *info, PointArray *points, rgb32 *colour, int32_t originX, int32_t originY, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    size_t I;
+    if (!findColoursTolerance(info, points, colour, x1, y1, x2, y2, tolerance))
+        return false;
+
+    __SpiralPoint *sorted = malloc(points->size * sizeof(__SpiralPoint));
+    if (!sorted)
+    {
+        freePointArray(points);
+        return false;
+    }
+
+    for (I = 0; I < points->size; ++I)
+    {
+        sorted[I].distance = __distanceSq(points->p[I].x, points->p[I].y, originX, originY);
+        sorted[I].point = points->p[I];
+    }
+
+    qsort(sorted, points->size, sizeof(__SpiralPoint), &__compareSpiral);
+    for (I = 0; I < points->size; ++I)
+        points->p[I] = sorted[I].point;
+
+    free(sorted);
+    return true;
 }
 
 bool findImage(CTSInfo *info, bitmap *imageToFind, int32_t *x, int32_t *y)
 {
-    return findImageIn(info, imageToFind, x, y, 0, 0, info->targetImage->width, info->targetImage->height);
+    uint32_t width, height;
+    getFrameSize(info, &width, &height);
+    return findImageIn(info, imageToFind, x, y, 0, 0, width, height);
 }
 
 bool findImageIn(CTSInfo *info, bitmap *imageToFind, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
@@ -251,42 +1298,327 @@ bool findImageIn(CTSInfo *info, bitmap *imageToFind, int32_t *x, int32_t *y, int
 
 bool findImageToleranceIn(CTSInfo *info, bitmap *imageToFind, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
 {
-    int I, J, XX, YY;
+    uint32_t width, height;
+    info->tol = tolerance;
+    getFrameSize(info, &width, &height);
+
+    /** Window sums only bound the RGB comparisons; HSL and Lab run the plain scan. They are built from targetImage,
+     *  so a search on a target view does without them.
+     **/
+    TemplateRegions regions;
+    __ImageFilters filters = {info, NULL, NULL, NULL, NULL, 0};
+    if (info->windowSums && !info->targetView.data && info->CTSNum >= -1 && info->CTSNum <= 1 && createTemplateRegions(&regions, imageToFind))
+        filters.regions = &regions;
+
+    if (width && height && info->kernels->findImage(info, imageToFind, &filters, x, y, x1, y1, x2, y2, tolerance))
+        return true;
+
+    *x = -1;
+    *y = -1;
+    return false;
+}
+
+bool findTemplateIn(CTSInfo *info, Template *tpl, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    uint16_t temp = info->CTSNum;
+    setCTS(info, -1);
+    bool Res = findTemplateToleranceIn(info, tpl, x, y, x1, y1, x2, y2, 0);
+    setCTS(info, temp);
+    return Res;
+}
+
+bool findTemplateToleranceIn(CTSInfo *info, Template *tpl, int32_t *x, int32_t *y, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    uint32_t width, height;
     info->tol = tolerance;
-    int dX = (x2 - x1) - (imageToFind->width - 1);
-    int dY = (y2 - y1) - (imageToFind->height - 1);
+    getFrameSize(info, &width, &height);
+
+    /** Every CTS compares the rare colours first. Block and window sums only bound the RGB comparisons; HSL and Lab
+     *  skip them, as do searches on a target view, since the sums are built from targetImage.
+     **/
+    __ImageFilters filters = {info, tpl, NULL, NULL, NULL, 0};
+    if (!info->targetView.data && info->CTSNum >= -1 && info->CTSNum <= 1)
+        filters.regions = &tpl->regions;
+
+    if (width && height && info->kernels->findImage(info, tpl->image, &filters, x, y, x1, y1, x2, y2, tolerance))
+        return true;
+
+    *x = -1;
+    *y = -1;
+    return false;
+}
+
+/** Positions are visited in row-major order, so a later position must score strictly lower to displace an equal one. **/
+static inline bool __worseMatch(const ImageMatch *a, const ImageMatch *b)
+{
+    return a->score != b->score ? a->score > b->score : (a->y != b->y ? a->y > b->y : a->x > b->x);
+}
+
+static void __siftDown(ImageMatch *heap, uint32_t size, uint32_t index)
+{
+    while (true)
+    {
+        uint32_t worst = index, left = 2 * index + 1, right = left + 1;
+        if (left < size && __worseMatch(&heap[left], &heap[worst]))
+            worst = left;
+        if (right < size && __worseMatch(&heap[right], &heap[worst]))
+            worst = right;
+        if (worst == index)
+            return;
+
+        ImageMatch temp = heap[index];
+        heap[index] = heap[worst];
+        heap[worst] = temp;
+        index = worst;
+    }
+}
+
+static void __siftUp(ImageMatch *heap, uint32_t index)
+{
+    while (index > 0)
+    {
+        uint32_t parent = (index - 1) / 2;
+        if (!__worseMatch(&heap[index], &heap[parent]))
+            return;
+
+        ImageMatch temp = heap[index];
+        heap[index] = heap[parent];
+        heap[parent] = temp;
+        index = parent;
+    }
+}
+
+static int __compareMatches(const void *first, const void *second)
+{
+    return __worseMatch(first, second) ? 1 : -1;
+}
+
+/** The template's opaque pixels are scored in horizontal runs by the SIMD difference kernels and positions are
+ *  abandoned between runs. Runs are capped at the kernels' limit so every partial sum fits 32 bits. The scores treat
+ *  every channel alike, so on a target view the template's colours are swapped instead of the frame's.
+ **/
+#define SCORE_RUN_MAX 4096
+
+typedef struct
+{
+    int32_t offset;
+    uint32_t start;
+    uint32_t length;
+} __ScoreRun;
 
-    for (I = 0; I < dY; ++I)
+static uint32_t __scoreImage(CTSInfo *info, diffRowT diff, const rgb32 *colours, const __ScoreRun *runs, uint32_t count, ImageMatch *heap, uint32_t k, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    int32_t I, J;
+    uint32_t R, size = 0;
+
+    for (I = y1; I < y2 && !__stopAtRow(info, I); ++I)
     {
-        for (J = 0; J < dX; ++J)
+        const rgb32 *row = getFrameRow(info, I);
+        for (J = x1; J < x2; ++J)
         {
-            for (YY = 0; YY < imageToFind->height; ++YY)
+            const rgb32 *origin = &row[J];
+            uint64_t score = 0, limit = size == k ? heap[0].score : UINT64_MAX;
+
+            for (R = 0; R < count && score < limit; ++R)
+                score += diff(&colours[runs[R].start], &origin[runs[R].offset], runs[R].length);
+
+            if (score >= limit && size == k)
+                continue;
+
+            ImageMatch match = {J, I, score};
+            if (size < k)
             {
-                for (XX = 0; XX < imageToFind->width; ++XX)
-                {
-                    rgb32* pixel = &imageToFind->pixels[YY * imageToFind->width + XX];
-                    rgb32* targetPixel = &info->targetImage->pixels[(YY + I) * info->targetImage->width + (XX + J)];
-
-                    if (pixel->a != 0)
-                    {
-                        if (!(*info->ctsFuncPtr)(info, pixel, targetPixel))
-                        {
-                            goto Skip;
-                        }
-                    }
-                }
+                heap[size] = match;
+                __siftUp(heap, size++);
+            }
+            else
+            {
+                heap[0] = match;
+                __siftDown(heap, size, 0);
             }
+        }
+    }
+    return size;
+}
 
-            *x = J + x1;
-            *y = I + y1;
-            return true;
+uint32_t findImagesTopK(CTSInfo *info, bitmap *imageToFind, ImageScore metric, ImageMatch *matches, uint32_t k, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    uint32_t I, J, size, count = 0, runCount = 0, width, height;
+    int32_t lastX = x2 - (int32_t)imageToFind->width, lastY = y2 - (int32_t)imageToFind->height;
+
+    getFrameSize(info, &width, &height);
+    if (k == 0 || lastX < x1 || lastY < y1 || !width || !height)
+        return 0;
+
+    width = __frameStride(info);
+
+    rgb32 *colours = malloc(imageToFind->width * imageToFind->height * sizeof(rgb32));
+    __ScoreRun *runs = malloc(imageToFind->width * imageToFind->height * sizeof(__ScoreRun));
+    if (!colours || !runs)
+    {
+        free(colours);
+        free(runs);
+        return 0;
+    }
 
-            Skip:
+    for (I = 0; I < imageToFind->height; ++I)
+    {
+        for (J = 0; J < imageToFind->width; ++J)
+        {
+            rgb32 *pixel = &imageToFind->pixels[I * imageToFind->width + J];
+            if (pixel->a == 0)
                 continue;
+
+            if (runCount == 0 || J == 0 || pixel[-1].a == 0 || runs[runCount - 1].length == SCORE_RUN_MAX)
+            {
+                __ScoreRun run = {I * width + J, count, 0};
+                runs[runCount++] = run;
+            }
+            ++runs[runCount - 1].length;
+            colours[count++] = __targetColour(info, pixel);
         }
     }
 
-    *x = -1;
-    *y = -1;
+    const SIMDDiffKernels *kernels = getSIMDDiffKernels();
+    size = __scoreImage(info, metric == ScoreSAD ? kernels->sad : kernels->ssd, colours, runs, runCount, matches, k, x1, y1, lastX + 1, lastY + 1);
+
+    qsort(matches, size, sizeof(ImageMatch), &__compareMatches);
+    free(colours);
+    free(runs);
+    return size;
+}
+
+bool findImageBest(CTSInfo *info, bitmap *imageToFind, ImageScore metric, ImageMatch *best, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    if (findImagesTopK(info, imageToFind, metric, best, 1, x1, y1, x2, y2))
+        return true;
+
+    best->x = -1;
+    best->y = -1;
+    best->score = UINT64_MAX;
     return false;
 }
+
+bool countColoursMulti(CTSInfo *info, const ColourQuery *queries, uint32_t count, uint32_t *counts, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    uint32_t I, Q;
+    bool Result = false;
+    memset(counts, 0, count * sizeof(uint32_t));
+
+    if (x2 <= x1 || y2 <= y1 || count == 0)
+        return false;
+
+    uint32_t bands = __bandCount(info, x1, y1, x2, y2);
+    uint32_t *partial = bands == 1 ? counts : calloc(bands * count, sizeof(uint32_t));
+    bool results[bands];
+    __MultiJob job = {info, queries, count, x1, y1, x2, y2, bands, partial, NULL, results};
+
+    if (!partial)
+        return false;
+
+    parallelFor(info->pool, bands, &__multiBand, &job);
+
+    for (Q = 0; Q < count; ++Q)
+    {
+        if (bands != 1)
+        {
+            for (I = 0; I < bands; ++I)
+                counts[Q] += partial[I * count + Q];
+        }
+        Result = Result || counts[Q];
+    }
+
+    if (partial != counts)
+        free(partial);
+    return Result;
+}
+
+bool findColoursMulti(CTSInfo *info, const ColourQuery *queries, uint32_t count, PointArray *results, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    uint32_t I, Q;
+    bool Result = false, success = true;
+
+    for (Q = 0; Q < count; ++Q)
+        clearPointArray(&results[Q]);
+
+    if (x2 <= x1 || y2 <= y1 || count == 0)
+        return false;
+
+    uint32_t bands = __bandCount(info, x1, y1, x2, y2);
+    PointArray *partial = bands == 1 ? results : malloc(bands * count * sizeof(PointArray));
+    bool bandResults[bands];
+    __MultiJob job = {info, queries, count, x1, y1, x2, y2, bands, NULL, partial, bandResults};
+
+    if (!partial)
+        return false;
+
+    if (bands != 1)
+    {
+        for (I = 0; I < bands * count; ++I)
+            initPointArray(&partial[I]);
+    }
+
+    parallelFor(info->pool, bands, &__multiBand, &job);
+
+    for (I = 0; I < bands; ++I)
+        success = success && bandResults[I];
+
+    if (bands != 1)
+    {
+        for (Q = 0; Q < count; ++Q)
+        {
+            for (I = 0; I < bands; ++I)
+            {
+                success = success && appendPoints(&results[Q], partial[I * count + Q].p, partial[I * count + Q].size);
+                freePointArray(&partial[I * count + Q]);
+            }
+        }
+        free(partial);
+    }
+
+    for (Q = 0; Q < count; ++Q)
+    {
+        if (!success)
+            clearPointArray(&results[Q]);
+        Result = Result || results[Q].size;
+    }
+    return Result;
+}
+
+bool scanColourRows(CTSInfo *info, const ColourScan *scans, uint32_t count, ColourScanResult *results, int32_t y1, int32_t y2)
+{
+    int32_t I;
+    uint32_t S;
+
+    for (I = y1; I < y2 && !__stopAtRow(info, I); ++I)
+    {
+        for (S = 0; S < count; ++S)
+        {
+            const ColourScan *scan = &scans[S];
+            ColourScanResult *result = &results[S];
+            const CTSKernels *kernels = __kernelsFor(scan->query.CTSNum);
+            rgb32 colour = scan->query.colour;
+
+            if (I < scan->y1 || I >= scan->y2 || scan->x2 <= scan->x1)
+                continue;
+
+            switch (scan->kind)
+            {
+                case ColourScanCount:
+                    result->count += kernels->count(info, &colour, scan->x1, I, scan->x2, I + 1, scan->query.tol);
+                    break;
+
+                case ColourScanFind:
+                    if (result->x == -1)
+                        kernels->find(info, &result->x, &result->y, &colour, scan->x1, I, scan->x2, I + 1, scan->query.tol);
+                    break;
+
+                case ColourScanFindAll:
+                    if (!kernels->findAll(info, &result->points, &colour, scan->x1, I, scan->x2, I + 1, scan->query.tol))
+                        return false;
+                    break;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,321 @@
+#include "finderasync.h"
+#include "framecache.h"
+
+#include <pthread.h>
+
+typedef enum {__AsyncCountColour, __AsyncFindColour, __AsyncFindColours, __AsyncFindImage, __AsyncFindDTM} __AsyncKind;
+
+struct FinderTask_t
+{
+    pthread_mutex_t lock;
+    pthread_cond_t finished;
+    FinderTaskState state;
+    bool cancel;
+    FinderExecutor *executor;
+    FinderTask *next;
+
+    __AsyncKind kind;
+    CTSInfo info;
+    rgb32 colour;
+    uint16_t tolerance;
+    int32_t x1, y1, x2, y2;
+    bitmap *image;
+    const CompiledDTM *dtm;
+    FinderTaskResult result;
+};
+
+/** A single thread running the tasks of one finder in the order they were started. The queue, the running task and
+ *  stop are guarded by lock; a task's state by its own lock, always taken after the executor's.
+ **/
+struct FinderExecutor_t
+{
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    FinderTask *head, *tail;
+    FinderTask *running;
+    bool stop;
+};
+
+static void __finishTask(FinderTask *task, FinderTaskState state)
+{
+    pthread_mutex_lock(&task->lock);
+    task->state = state;
+    if (state == FinderTaskCancelled)
+        freePointArray(&task->result.points);
+
+    pthread_cond_broadcast(&task->finished);
+    pthread_mutex_unlock(&task->lock);
+}
+
+/** The copy of the finder's CTSInfo has a frame cache of its own. The finder's cache drops its data whenever a search
+ *  on another thread moves to a different target, which would free data this search is still reading.
+ **/
+static void __runTask(FinderTask *task)
+{
+    CTSInfo *info = &task->info;
+    FinderTaskResult *result = &task->result;
+
+    switch (task->kind)
+    {
+        case __AsyncCountColour:
+            result->count = countColourTolerance(info, &task->colour, task->x1, task->y1, task->x2, task->y2, task->tolerance);
+            result->found = result->count;
+            break;
+
+        case __AsyncFindColour:
+            result->found = findColourTolerance(info, &result->x, &result->y, &task->colour, task->x1, task->y1, task->x2, task->y2, task->tolerance);
+            break;
+
+        case __AsyncFindColours:
+            result->found = findColoursTolerance(info, &result->points, &task->colour, task->x1, task->y1, task->x2, task->y2, task->tolerance);
+            break;
+
+        case __AsyncFindImage:
+            result->found = findImageToleranceIn(info, task->image, &result->x, &result->y, task->x1, task->y1, task->x2, task->y2, task->tolerance);
+            break;
+
+        case __AsyncFindDTM:
+            result->found = findCompiledDTM(info, task->dtm, &result->x, &result->y, task->x1, task->y1, task->x2, task->y2);
+            break;
+    }
+
+    freeFrameCache(info);
+}
+
+static void *__executorThread(void *arg)
+{
+    FinderExecutor *executor = arg;
+
+    pthread_mutex_lock(&executor->lock);
+    while (true)
+    {
+        while (!executor->stop && !executor->head)
+            pthread_cond_wait(&executor->wake, &executor->lock);
+
+        if (executor->stop)
+            break;
+
+        FinderTask *task = executor->head;
+        executor->head = task->next;
+        if (!executor->head)
+            executor->tail = NULL;
+
+        pthread_mutex_lock(&task->lock);
+        task->state = FinderTaskRunning;
+        pthread_mutex_unlock(&task->lock);
+
+        executor->running = task;
+        pthread_mutex_unlock(&executor->lock);
+
+        __runTask(task);
+
+        pthread_mutex_lock(&executor->lock);
+        executor->running = NULL;
+        __finishTask(task, __atomic_load_n(&task->cancel, __ATOMIC_RELAXED) ? FinderTaskCancelled : FinderTaskDone);
+    }
+    pthread_mutex_unlock(&executor->lock);
+    return NULL;
+}
+
+static FinderExecutor *__createExecutor(void)
+{
+    FinderExecutor *executor = calloc(1, sizeof(FinderExecutor));
+    if (!executor)
+        return NULL;
+
+    pthread_mutex_init(&executor->lock, NULL);
+    pthread_cond_init(&executor->wake, NULL);
+
+    if (pthread_create(&executor->thread, NULL, &__executorThread, executor) != 0)
+    {
+        pthread_cond_destroy(&executor->wake);
+        pthread_mutex_destroy(&executor->lock);
+        free(executor);
+        return NULL;
+    }
+    return executor;
+}
+
+void freeFinderExecutor(Finder *finder)
+{
+    FinderExecutor *executor = finder->executor;
+    if (!executor)
+        return;
+
+    pthread_mutex_lock(&executor->lock);
+    executor->stop = true;
+    while (executor->head)
+    {
+        FinderTask *task = executor->head;
+        executor->head = task->next;
+        __finishTask(task, FinderTaskCancelled);
+    }
+
+    executor->tail = NULL;
+    if (executor->running)
+        __atomic_store_n(&executor->running->cancel, true, __ATOMIC_RELAXED);
+
+    pthread_cond_broadcast(&executor->wake);
+    pthread_mutex_unlock(&executor->lock);
+
+    pthread_join(executor->thread, NULL);
+    pthread_cond_destroy(&executor->wake);
+    pthread_mutex_destroy(&executor->lock);
+    free(executor);
+    finder->executor = NULL;
+}
+
+static FinderTask *__createTask(Finder *finder, __AsyncKind kind, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    if (!finder->executor && !(finder->executor = __createExecutor()))
+        return NULL;
+
+    FinderTask *task = calloc(1, sizeof(FinderTask));
+    if (!task)
+        return NULL;
+
+    pthread_mutex_init(&task->lock, NULL);
+    pthread_cond_init(&task->finished, NULL);
+    task->state = FinderTaskQueued;
+    task->executor = finder->executor;
+    task->kind = kind;
+    task->info = finder->info;
+    task->info.cancel = &task->cancel;
+    task->info.cache = NULL;
+    task->tolerance = tolerance;
+    task->x1 = x1;
+    task->y1 = y1;
+    task->x2 = x2;
+    task->y2 = y2;
+    task->result.x = -1;
+    task->result.y = -1;
+    initPointArray(&task->result.points);
+    return task;
+}
+
+static FinderTask *__submitTask(FinderTask *task)
+{
+    FinderExecutor *executor = task->executor;
+
+    pthread_mutex_lock(&executor->lock);
+    if (executor->tail)
+        executor->tail->next = task;
+    else
+        executor->head = task;
+
+    executor->tail = task;
+    pthread_cond_signal(&executor->wake);
+    pthread_mutex_unlock(&executor->lock);
+    return task;
+}
+
+static FinderTask *__colourTask(Finder *finder, __AsyncKind kind, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    FinderTask *task = __createTask(finder, kind, x1, y1, x2, y2, tolerance);
+    if (!task)
+        return NULL;
+
+    task->colour = *colour;
+    return __submitTask(task);
+}
+
+FinderTask *countColourToleranceAsync(Finder *finder, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    return __colourTask(finder, __AsyncCountColour, colour, x1, y1, x2, y2, tolerance);
+}
+
+FinderTask *findColourToleranceAsync(Finder *finder, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    return __colourTask(finder, __AsyncFindColour, colour, x1, y1, x2, y2, tolerance);
+}
+
+FinderTask *findColoursToleranceAsync(Finder *finder, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    return __colourTask(finder, __AsyncFindColours, colour, x1, y1, x2, y2, tolerance);
+}
+
+FinderTask *findImageToleranceInAsync(Finder *finder, bitmap *image, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    FinderTask *task = __createTask(finder, __AsyncFindImage, x1, y1, x2, y2, tolerance);
+    if (!task)
+        return NULL;
+
+    task->image = image;
+    return __submitTask(task);
+}
+
+FinderTask *findCompiledDTMAsync(Finder *finder, const CompiledDTM *dtm, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    FinderTask *task = __createTask(finder, __AsyncFindDTM, x1, y1, x2, y2, 0);
+    if (!task)
+        return NULL;
+
+    task->dtm = dtm;
+    return __submitTask(task);
+}
+
+FinderTaskState pollFinderTask(FinderTask *task)
+{
+    pthread_mutex_lock(&task->lock);
+    FinderTaskState state = task->state;
+    pthread_mutex_unlock(&task->lock);
+    return state;
+}
+
+FinderTaskState waitFinderTask(FinderTask *task)
+{
+    pthread_mutex_lock(&task->lock);
+    while (task->state == FinderTaskQueued || task->state == FinderTaskRunning)
+        pthread_cond_wait(&task->finished, &task->lock);
+
+    FinderTaskState state = task->state;
+    pthread_mutex_unlock(&task->lock);
+    return state;
+}
+
+/** A queued task is unlinked under the executor's lock, so it cannot be picked up at the same time. It may have
+ *  started in between, in which case its search sees the flag instead.
+ **/
+void cancelFinderTask(FinderTask *task)
+{
+    FinderTask **link;
+    __atomic_store_n(&task->cancel, true, __ATOMIC_RELAXED);
+
+    if (pollFinderTask(task) != FinderTaskQueued)
+        return;
+
+    FinderExecutor *executor = task->executor;
+    pthread_mutex_lock(&executor->lock);
+    for (link = &executor->head; *link && *link != task; link = &(*link)->next);
+
+    if (*link)
+    {
+        *link = task->next;
+        if (executor->tail == task)
+        {
+            for (executor->tail = executor->head; executor->tail && executor->tail->next; executor->tail = executor->tail->next);
+        }
+        __finishTask(task, FinderTaskCancelled);
+    }
+    pthread_mutex_unlock(&executor->lock);
+}
+
+const FinderTaskResult *getFinderTaskResult(FinderTask *task)
+{
+    return pollFinderTask(task) == FinderTaskDone ? &task->result : NULL;
+}
+
+void freeFinderTask(FinderTask *task)
+{
+    if (!task)
+        return;
+
+    cancelFinderTask(task);
+    waitFinderTask(task);
+
+    freePointArray(&task->result.points);
+    pthread_cond_destroy(&task->finished);
+    pthread_mutex_destroy(&task->lock);
+    free(task);
+}
@@ -0,0 +1,292 @@
+#include "finderbatch.h"
+#include "framecache.h"
+
+/** Colour work smaller than this, summed over all colour queries, runs as one band. Larger work is cut into a few row
+ *  bands per thread so that uneven bands still balance out.
+ **/
+#define BATCH_PARALLEL_MIN_PIXELS (256 * 256)
+#define BATCH_BANDS_PER_THREAD 4
+
+typedef struct
+{
+    Finder *finder;
+    FinderBatch *batch;
+    const ColourScan *scans;
+    const uint32_t *scanQueries;
+    uint32_t scanCount;
+    ColourScanResult *partial;
+    bool *results;
+    int32_t top, bottom;
+    uint32_t bands;
+    const uint32_t *heavyQueries;
+    uint32_t heavyCount;
+    CTSInfo *copies;
+} __BatchJob;
+
+void initFinderBatch(FinderBatch *batch)
+{
+    batch->queries = NULL;
+    batch->count = 0;
+    batch->capacity = 0;
+}
+
+void freeFinderBatch(FinderBatch *batch)
+{
+    uint32_t I;
+    for (I = 0; I < batch->capacity; ++I)
+        freePointArray(&batch->queries[I].points);
+
+    free(batch->queries);
+    initFinderBatch(batch);
+}
+
+void clearFinderBatch(FinderBatch *batch)
+{
+    batch->count = 0;
+}
+
+static BatchQuery *__addQuery(FinderBatch *batch, BatchQueryKind kind, int16_t CTSNum, uint16_t tolerance, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    uint32_t I;
+    if (batch->count == batch->capacity)
+    {
+        uint32_t capacity = batch->capacity ? batch->capacity * 2 : 16;
+        BatchQuery *queries = realloc(batch->queries, capacity * sizeof(BatchQuery));
+        if (!queries || capacity > INT32_MAX)
+        {
+            if (queries)
+                batch->queries = queries;
+            return NULL;
+        }
+
+        for (I = batch->capacity; I < capacity; ++I)
+            initPointArray(&queries[I].points);
+
+        batch->queries = queries;
+        batch->capacity = capacity;
+    }
+
+    BatchQuery *query = &batch->queries[batch->count++];
+    query->kind = kind;
+    query->CTSNum = CTSNum;
+    query->tolerance = tolerance;
+    query->x1 = x1;
+    query->y1 = y1;
+    query->x2 = x2;
+    query->y2 = y2;
+    query->image = NULL;
+    query->dtm = NULL;
+    return query;
+}
+
+static int32_t __addColourQuery(FinderBatch *batch, BatchQueryKind kind, rgb32 *colour, int16_t CTSNum, uint16_t tolerance, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    BatchQuery *query = __addQuery(batch, kind, CTSNum, tolerance, x1, y1, x2, y2);
+    if (!query)
+        return -1;
+
+    query->colour = *colour;
+    return (int32_t)(batch->count - 1);
+}
+
+int32_t addCountColourQuery(FinderBatch *batch, rgb32 *colour, int16_t CTSNum, uint16_t tolerance, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    return __addColourQuery(batch, BatchCountColour, colour, CTSNum, tolerance, x1, y1, x2, y2);
+}
+
+int32_t addFindColourQuery(FinderBatch *batch, rgb32 *colour, int16_t CTSNum, uint16_t tolerance, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    return __addColourQuery(batch, BatchFindColour, colour, CTSNum, tolerance, x1, y1, x2, y2);
+}
+
+int32_t addFindColoursQuery(FinderBatch *batch, rgb32 *colour, int16_t CTSNum, uint16_t tolerance, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    return __addColourQuery(batch, BatchFindColours, colour, CTSNum, tolerance, x1, y1, x2, y2);
+}
+
+int32_t addFindImageQuery(FinderBatch *batch, bitmap *image, int16_t CTSNum, uint16_t tolerance, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    BatchQuery *query = __addQuery(batch, BatchFindImage, CTSNum, tolerance, x1, y1, x2, y2);
+    if (!query)
+        return -1;
+
+    query->image = image;
+    return (int32_t)(batch->count - 1);
+}
+
+int32_t addFindDTMQuery(FinderBatch *batch, const CompiledDTM *dtm, int16_t CTSNum, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    BatchQuery *query = __addQuery(batch, BatchFindDTM, CTSNum, 0, x1, y1, x2, y2);
+    if (!query)
+        return -1;
+
+    query->dtm = dtm;
+    return (int32_t)(batch->count - 1);
+}
+
+/** Image and DTM queries are the longest tasks, so they take the lowest indices and start first. Each runs on its
+ *  own copy of the finder's CTSInfo, since searches write their CTS and tolerance to it. The copies share the
+ *  finder's frame cache, so data derived from the frame is built once for all of them.
+ **/
+static void __batchTask(void *data, uint32_t index)
+{
+    __BatchJob *job = data;
+
+    if (index < job->heavyCount)
+    {
+        BatchQuery *query = &job->batch->queries[job->heavyQueries[index]];
+        CTSInfo *info = &job->copies[index];
+
+        *info = job->finder->info;
+        setCTS(info, query->CTSNum);
+
+        if (query->kind == BatchFindImage)
+            query->found = findImageToleranceIn(info, query->image, &query->x, &query->y, query->x1, query->y1, query->x2, query->y2, query->tolerance);
+        else
+            query->found = findCompiledDTM(info, query->dtm, &query->x, &query->y, query->x1, query->y1, query->x2, query->y2);
+        return;
+    }
+
+    uint32_t band = index - job->heavyCount;
+    uint64_t rows = job->bottom - job->top;
+    int32_t top = job->top + (int32_t)(rows * band / job->bands);
+    int32_t bottom = job->top + (int32_t)(rows * (band + 1) / job->bands);
+    job->results[band] = scanColourRows(&job->finder->info, job->scans, job->scanCount, &job->partial[band * job->scanCount], top, bottom);
+}
+
+static uint32_t __batchBands(Finder *finder, const ColourScan *scans, uint32_t count, int32_t top, int32_t bottom)
+{
+    uint32_t I, threads = threadPoolSize(finder->info.pool);
+    uint64_t pixels = 0;
+
+    for (I = 0; I < count; ++I)
+        pixels += (uint64_t)(scans[I].x2 - scans[I].x1) * (scans[I].y2 - scans[I].y1);
+
+    if (!count)
+        return 0;
+    if (threads < 2 || pixels < BATCH_PARALLEL_MIN_PIXELS)
+        return 1;
+    return (uint32_t)(bottom - top) < threads * BATCH_BANDS_PER_THREAD ? (uint32_t)(bottom - top) : threads * BATCH_BANDS_PER_THREAD;
+}
+
+/** Bands hold their own results, which are combined in band order: counts are summed, the first band holding a hit
+ *  gives the first match, and points are appended so they stay in row-major order.
+ **/
+static bool __mergeBands(__BatchJob *job)
+{
+    uint32_t I, S;
+    bool Result = true;
+
+    for (I = 0; I < job->bands; ++I)
+        Result = Result && job->results[I];
+
+    for (S = 0; S < job->scanCount; ++S)
+    {
+        BatchQuery *query = &job->batch->queries[job->scanQueries[S]];
+        for (I = 0; I < job->bands; ++I)
+        {
+            ColourScanResult *partial = &job->partial[I * job->scanCount + S];
+            query->count += partial->count;
+
+            if (query->x == -1 && partial->x != -1)
+            {
+                query->x = partial->x;
+                query->y = partial->y;
+            }
+
+            if (query->kind == BatchFindColours)
+            {
+                Result = Result && appendPoints(&query->points, partial->points.p, partial->points.size);
+                freePointArray(&partial->points);
+            }
+        }
+
+        query->found = query->kind == BatchFindColours ? query->points.size : query->kind == BatchCountColour ? query->count : query->x != -1;
+    }
+    return Result;
+}
+
+/** The finder's cache is created before the tasks start. Only if that failed may copies have created caches of their
+ *  own, which the finder adopts, or frees if it has one.
+ **/
+static void __adoptCaches(Finder *finder, CTSInfo *copies, uint32_t count)
+{
+    uint32_t I;
+    for (I = 0; I < count; ++I)
+    {
+        if (!copies[I].cache || copies[I].cache == finder->info.cache)
+            continue;
+
+        if (!finder->info.cache)
+            finder->info.cache = copies[I].cache;
+        else
+            freeFrameCache(&copies[I]);
+    }
+}
+
+bool runFinderBatch(Finder *finder, FinderBatch *batch)
+{
+    uint32_t I, scanCount = 0, heavyCount = 0;
+    int32_t top = INT32_MAX, bottom = INT32_MIN;
+    ColourScan *scans = malloc(batch->count * sizeof(ColourScan) + 1);
+    uint32_t *scanQueries = malloc(batch->count * sizeof(uint32_t) + 1);
+    uint32_t *heavyQueries = malloc(batch->count * sizeof(uint32_t) + 1);
+    CTSInfo *copies = malloc(batch->count * sizeof(CTSInfo) + 1);
+    bool Result = scans && scanQueries && heavyQueries && copies;
+
+    for (I = 0; I < batch->count && Result; ++I)
+    {
+        BatchQuery *query = &batch->queries[I];
+        query->found = false;
+        query->count = 0;
+        query->x = -1;
+        query->y = -1;
+        clearPointArray(&query->points);
+
+        if (query->kind == BatchFindImage || query->kind == BatchFindDTM)
+        {
+            heavyQueries[heavyCount++] = I;
+            continue;
+        }
+
+        if (query->x2 <= query->x1 || query->y2 <= query->y1)
+            continue;
+
+        ColourScan scan = {{query->colour, query->tolerance, query->CTSNum}, query->kind == BatchCountColour ? ColourScanCount : query->kind == BatchFindColour ? ColourScanFind : ColourScanFindAll, query->x1, query->y1, query->x2, query->y2};
+        scans[scanCount] = scan;
+        scanQueries[scanCount++] = I;
+        top = query->y1 < top ? query->y1 : top;
+        bottom = query->y2 > bottom ? query->y2 : bottom;
+    }
+
+    uint32_t bands = Result ? __batchBands(finder, scans, scanCount, top, bottom) : 0;
+    ColourScanResult *partial = malloc((size_t)bands * scanCount * sizeof(ColourScanResult) + 1);
+    bool *results = malloc(bands * sizeof(bool) + 1);
+    Result = Result && partial && results;
+
+    if (Result)
+    {
+        __BatchJob job = {finder, batch, scans, scanQueries, scanCount, partial, results, top, bottom, bands, heavyQueries, heavyCount, copies};
+        for (I = 0; I < bands * scanCount; ++I)
+        {
+            ColourScanResult empty = {0, -1, -1, {NULL, 0, 0, false}};
+            partial[I] = empty;
+            initPointArray(&partial[I].points);
+        }
+
+        if (heavyCount)
+            createFrameCache(&finder->info);
+
+        parallelFor(finder->info.pool, heavyCount + bands, &__batchTask, &job);
+        __adoptCaches(finder, copies, heavyCount);
+        Result = __mergeBands(&job);
+    }
+
+    free(scans);
+    free(scanQueries);
+    free(heavyQueries);
+    free(copies);
+    free(partial);
+    free(results);
+    return Result;
+}
@@ -0,0 +1,108 @@
+#include "framecache.h"
+
+#include <stdatomic.h>
+#include <pthread.h>
+
+typedef struct
+{
+    void *data;
+    freeFrameDataT release;
+} FrameData;
+
+struct FrameCache_t
+{
+    pthread_mutex_t lock;
+    const rgb32 *pixels;
+    uint64_t frame;
+    uint32_t width;
+    uint32_t height;
+    FrameData slots[FrameDataKinds];
+};
+
+static void __releaseFrameData(FrameCache *cache)
+{
+    uint32_t I;
+    for (I = 0; I < FrameDataKinds; ++I)
+    {
+        if (cache->slots[I].data)
+            cache->slots[I].release(cache->slots[I].data);
+
+        cache->slots[I].data = NULL;
+        cache->slots[I].release = NULL;
+    }
+}
+
+/** The cache is created on first use. Racing threads publish through a compare-exchange and the loser frees its copy. **/
+static FrameCache *__frameCache(CTSInfo *info)
+{
+    _Atomic(FrameCache *) *slot = (_Atomic(FrameCache *) *)&info->cache;
+    FrameCache *cache = atomic_load(slot);
+    if (cache)
+        return cache;
+
+    FrameCache *created = calloc(1, sizeof(FrameCache));
+    if (!created)
+        return NULL;
+
+    pthread_mutex_init(&created->lock, NULL);
+    if (!atomic_compare_exchange_strong(slot, &cache, created))
+    {
+        pthread_mutex_destroy(&created->lock);
+        free(created);
+        return cache;
+    }
+    return created;
+}
+
+bool createFrameCache(CTSInfo *info)
+{
+    return __frameCache(info) != NULL;
+}
+
+void *getFrameData(CTSInfo *info, FrameDataKind kind, buildFrameDataT build, freeFrameDataT release)
+{
+    FrameCache *cache = __frameCache(info);
+    if (!cache || !info->targetImage)
+        return NULL;
+
+    pthread_mutex_lock(&cache->lock);
+    if (cache->pixels != info->targetImage->pixels || cache->frame != info->frame || cache->width != info->targetImage->width || cache->height != info->targetImage->height)
+    {
+        __releaseFrameData(cache);
+        cache->pixels = info->targetImage->pixels;
+        cache->frame = info->frame;
+        cache->width = info->targetImage->width;
+        cache->height = info->targetImage->height;
+    }
+
+    if (!cache->slots[kind].data && (cache->slots[kind].data = build(info)))
+        cache->slots[kind].release = release;
+
+    void *data = cache->slots[kind].data;
+    pthread_mutex_unlock(&cache->lock);
+    return data;
+}
+
+void invalidateFrameCache(CTSInfo *info)
+{
+    FrameCache *cache = info->cache;
+    if (!cache)
+        return;
+
+    pthread_mutex_lock(&cache->lock);
+    __releaseFrameData(cache);
+    cache->pixels = NULL;
+    pthread_mutex_unlock(&cache->lock);
+}
+
+void freeFrameCache(CTSInfo *info)
+{
+    FrameCache *cache = info->cache;
+    if (!cache)
+        return;
+
+    __releaseFrameData(cache);
+    pthread_mutex_destroy(&cache->lock);
+    free(cache);
+    info->cache = NULL;
+}
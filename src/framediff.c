@@ -0,0 +1,272 @@
+#include "framediff.h"
+#include "simd.h"
+
+#include <string.h>
+
+/** The difference kernels sum at most this many pixels per call. **/
+#define DIFF_RUN_MAX 4096
+
+typedef struct
+{
+    FrameDiff *diff;
+    CTSInfo *info;
+} __DiffJob;
+
+void initFrameDiff(FrameDiff *diff)
+{
+    memset(diff, 0, sizeof(FrameDiff));
+}
+
+void freeFrameDiff(FrameDiff *diff)
+{
+    free(diff->dirty);
+    free(diff->previous);
+    initFrameDiff(diff);
+}
+
+/** A frame of a new size or layout has nothing to be compared with, so it is copied whole and every tile is dirty. **/
+static bool __resetFrameDiff(FrameDiff *diff, CTSInfo *info, uint32_t width, uint32_t height)
+{
+    uint32_t I;
+    uint64_t frame = diff->frame;
+    freeFrameDiff(diff);
+
+    diff->tilesX = (width + FRAME_DIFF_TILE - 1) / FRAME_DIFF_TILE;
+    diff->tilesY = (height + FRAME_DIFF_TILE - 1) / FRAME_DIFF_TILE;
+    diff->dirty = malloc((size_t)diff->tilesX * diff->tilesY);
+    diff->previous = malloc((size_t)width * height * sizeof(rgb32));
+
+    if (!diff->dirty || !diff->previous)
+    {
+        freeFrameDiff(diff);
+        return false;
+    }
+
+    for (I = 0; I < height; ++I)
+        memcpy(&diff->previous[(size_t)I * width], getFrameRow(info, I), width * sizeof(rgb32));
+
+    memset(diff->dirty, 1, (size_t)diff->tilesX * diff->tilesY);
+    diff->width = width;
+    diff->height = height;
+    diff->dirtyCount = diff->tilesX * diff->tilesY;
+    diff->frame = frame + 1;
+    diff->bgr = info->targetView.data;
+    return true;
+}
+
+/** Unchanged rows are the common case, so each row is compared whole first and only split into tiles when it differs.
+ *  Tiles already found dirty are not compared again. The rows of dirty tiles are then copied for the next frame.
+ **/
+static void __diffTileRow(void *data, uint32_t tileY)
+{
+    __DiffJob *job = data;
+    FrameDiff *diff = job->diff;
+    const diffRowT sad = getSIMDDiffKernels()->sad;
+    uint8_t *dirty = &diff->dirty[(size_t)tileY * diff->tilesX];
+    uint32_t I, J, K, top = tileY * FRAME_DIFF_TILE;
+    uint32_t bottom = top + FRAME_DIFF_TILE < diff->height ? top + FRAME_DIFF_TILE : diff->height;
+
+    memset(dirty, 0, diff->tilesX);
+    for (I = top; I < bottom; ++I)
+    {
+        const rgb32 *row = getFrameRow(job->info, I);
+        const rgb32 *previous = &diff->previous[(size_t)I * diff->width];
+
+        for (J = 0; J < diff->width; J += DIFF_RUN_MAX)
+        {
+            uint32_t end = J + DIFF_RUN_MAX < diff->width ? J + DIFF_RUN_MAX : diff->width;
+            if (!sad(&row[J], &previous[J], end - J))
+                continue;
+
+            for (K = J; K < end; K += FRAME_DIFF_TILE)
+            {
+                uint32_t length = K + FRAME_DIFF_TILE < end ? FRAME_DIFF_TILE : end - K;
+                if (!dirty[K / FRAME_DIFF_TILE] && sad(&row[K], &previous[K], length))
+                    dirty[K / FRAME_DIFF_TILE] = 1;
+            }
+        }
+    }
+
+    for (I = top; I < bottom; ++I)
+    {
+        const rgb32 *row = getFrameRow(job->info, I);
+        rgb32 *previous = &diff->previous[(size_t)I * diff->width];
+
+        for (J = 0; J < diff->tilesX; J = K)
+        {
+            for (; J < diff->tilesX && !dirty[J]; ++J);
+            for (K = J; K < diff->tilesX && dirty[K]; ++K);
+
+            if (J < K)
+            {
+                uint32_t left = J * FRAME_DIFF_TILE, right = K * FRAME_DIFF_TILE < diff->width ? K * FRAME_DIFF_TILE : diff->width;
+                memcpy(&previous[left], &row[left], (right - left) * sizeof(rgb32));
+            }
+        }
+    }
+}
+
+bool updateFrameDiff(FrameDiff *diff, CTSInfo *info)
+{
+    uint32_t I, width, height;
+    getFrameSize(info, &width, &height);
+
+    if (!width || !height)
+    {
+        freeFrameDiff(diff);
+        return false;
+    }
+
+    if (!diff->previous || diff->width != width || diff->height != height || diff->bgr != (info->targetView.data != NULL))
+    {
+        ++info->frame;
+        return __resetFrameDiff(diff, info, width, height);
+    }
+
+    __DiffJob job = {diff, info};
+    parallelFor(info->pool, diff->tilesY, &__diffTileRow, &job);
+
+    diff->dirtyCount = 0;
+    for (I = 0; I < diff->tilesX * diff->tilesY; ++I)
+        diff->dirtyCount += diff->dirty[I];
+
+    /** Changes made in place are only seen here, so they start a new frame for the data derived from it. **/
+    if (diff->dirtyCount)
+        ++info->frame;
+
+    ++diff->frame;
+    return true;
+}
+
+bool initColourWatch(ColourWatch *watch, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    watch->colour = *colour;
+    watch->tolerance = tolerance;
+    watch->CTSNum = 0;
+    watch->hueMod = 0.0f;
+    watch->satMod = 0.0f;
+    watch->count = 0;
+    watch->frame = 0;
+    initMatchMask(&watch->mask);
+    return resizeMatchMask(&watch->mask, x1, y1, x2, y2);
+}
+
+void freeColourWatch(ColourWatch *watch)
+{
+    freeMatchMask(&watch->mask);
+    watch->count = 0;
+    watch->frame = 0;
+}
+
+/** Replaces count bits of dst from bit offset on with the first count bits of src and returns how many of the
+ *  replaced bits were set.
+ **/
+static uint32_t __spliceBits(uint32_t *dst, int32_t offset, const uint32_t *src, int32_t count)
+{
+    int32_t I;
+    uint32_t Result = 0;
+
+    for (I = 0; I < count; I += 32)
+    {
+        int32_t taken = count - I < 32 ? count - I : 32;
+        uint32_t *out = &dst[(offset + I) >> 5];
+        uint64_t keep = (uint64_t)(taken == 32 ? UINT32_MAX : (1u << taken) - 1) << ((offset + I) & 31);
+        uint64_t word = ((uint64_t)src[I >> 5] << ((offset + I) & 31)) & keep;
+
+        Result += __builtin_popcount(out[0] & (uint32_t)keep);
+        out[0] = (out[0] & ~(uint32_t)keep) | (uint32_t)word;
+
+        if (keep >> 32)
+        {
+            Result += __builtin_popcount(out[1] & (uint32_t)(keep >> 32));
+            out[1] = (out[1] & ~(uint32_t)(keep >> 32)) | (uint32_t)(word >> 32);
+        }
+    }
+    return Result;
+}
+
+static void __rescanRun(CTSInfo *info, ColourWatch *watch, uint32_t *bits, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    int32_t I;
+    uint32_t J, words = (x2 - x1 + 31) / 32;
+    MatchMask *mask = &watch->mask;
+
+    maskColoursTolerance(info, bits, words, &watch->colour, x1, y1, x2, y2, watch->tolerance);
+    for (I = y1; I < y2; ++I)
+    {
+        const uint32_t *row = &bits[(size_t)(I - y1) * words];
+        for (J = 0; J < words; ++J)
+            watch->count += __builtin_popcount(row[J]);
+
+        watch->count -= __spliceBits(&mask->bits[(size_t)(I - mask->y1) * mask->words], x1 - mask->x1, row, x2 - x1);
+    }
+}
+
+/** Clean tiles keep the matches of the comparison they were scanned with, so any change of it rescans the area. **/
+static inline bool __sameComparison(const ColourWatch *watch, const CTSInfo *info)
+{
+    return watch->CTSNum == info->CTSNum && watch->hueMod == info->hueMod && watch->satMod == info->satMod;
+}
+
+bool updateColourWatch(CTSInfo *info, ColourWatch *watch, const FrameDiff *diff)
+{
+    MatchMask *mask = &watch->mask;
+    info->tol = watch->tolerance;
+
+    if (!watch->frame || watch->frame + 1 != diff->frame || !__sameComparison(watch, info))
+    {
+        watch->frame = 0;
+        if (!findColoursMask(info, mask, &watch->colour, mask->x1, mask->y1, mask->x2, mask->y2, watch->tolerance))
+            return false;
+
+        watch->count = countMatchMask(mask);
+        watch->CTSNum = info->CTSNum;
+        watch->hueMod = info->hueMod;
+        watch->satMod = info->satMod;
+        watch->frame = diff->frame;
+        return true;
+    }
+
+    uint32_t *bits = malloc((size_t)mask->words * FRAME_DIFF_TILE * sizeof(uint32_t));
+    int32_t tileY, tileX, next;
+    if (!bits)
+    {
+        watch->frame = 0;
+        return false;
+    }
+
+    for (tileY = mask->y1 / FRAME_DIFF_TILE; tileY * FRAME_DIFF_TILE < mask->y2; ++tileY)
+    {
+        const uint8_t *dirty = &diff->dirty[(size_t)tileY * diff->tilesX];
+        int32_t top = tileY * FRAME_DIFF_TILE > mask->y1 ? tileY * FRAME_DIFF_TILE : mask->y1;
+        int32_t bottom = (tileY + 1) * FRAME_DIFF_TILE < mask->y2 ? (tileY + 1) * FRAME_DIFF_TILE : mask->y2;
+
+        for (tileX = mask->x1 / FRAME_DIFF_TILE; tileX * FRAME_DIFF_TILE < mask->x2; tileX = next)
+        {
+            for (; tileX * FRAME_DIFF_TILE < mask->x2 && !dirty[tileX]; ++tileX);
+            for (next = tileX; next * FRAME_DIFF_TILE < mask->x2 && dirty[next]; ++next);
+
+            if (tileX < next)
+            {
+                int32_t left = tileX * FRAME_DIFF_TILE > mask->x1 ? tileX * FRAME_DIFF_TILE : mask->x1;
+                int32_t right = next * FRAME_DIFF_TILE < mask->x2 ? next * FRAME_DIFF_TILE : mask->x2;
+                __rescanRun(info, watch, bits, left, top, right, bottom);
+            }
+        }
+    }
+
+    free(bits);
+    watch->frame = diff->frame;
+    return true;
+}
+
+bool colourWatchPoints(const ColourWatch *watch, PointArray *points)
+{
+    clearPointArray(points);
+    if (!matchMaskPoints(&watch->mask, points))
+    {
+        clearPointArray(points);
+        return false;
+    }
+    return points->size;
+}
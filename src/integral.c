@@ -0,0 +1,141 @@
+#include "integral.h"
+#include "framecache.h"
+
+#include <math.h>
+
+IntegralImage *createIntegralImage(bitmap *image)
+{
+    uint32_t I, J, stride = image->width + 1;
+    IntegralImage *integral = malloc(sizeof(IntegralImage));
+    if (!integral)
+        return NULL;
+
+    integral->width = image->width;
+    integral->height = image->height;
+    integral->sums = calloc((size_t)stride * (image->height + 1) * 3, sizeof(uint32_t));
+    integral->energy = calloc((size_t)stride * (image->height + 1), sizeof(uint64_t));
+
+    if (!integral->sums || !integral->energy)
+    {
+        freeIntegralImage(integral);
+        return NULL;
+    }
+
+    for (I = 0; I < image->height; ++I)
+    {
+        const rgb32 *row = &image->pixels[I * image->width];
+        uint32_t *above = &integral->sums[(size_t)I * stride * 3], *sums = above + stride * 3;
+        uint64_t *aboveEnergy = &integral->energy[(size_t)I * stride], *energy = aboveEnergy + stride;
+        uint32_t R = 0, G = 0, B = 0;
+        uint64_t E = 0;
+
+        for (J = 0; J < image->width; ++J)
+        {
+            R += row[J].r;
+            G += row[J].g;
+            B += row[J].b;
+            E += row[J].r * row[J].r + row[J].g * row[J].g + row[J].b * row[J].b;
+
+            sums[(J + 1) * 3 + 0] = above[(J + 1) * 3 + 0] + R;
+            sums[(J + 1) * 3 + 1] = above[(J + 1) * 3 + 1] + G;
+            sums[(J + 1) * 3 + 2] = above[(J + 1) * 3 + 2] + B;
+            energy[J + 1] = aboveEnergy[J + 1] + E;
+        }
+    }
+    return integral;
+}
+
+void freeIntegralImage(IntegralImage *integral)
+{
+    if (!integral)
+        return;
+
+    free(integral->sums);
+    free(integral->energy);
+    free(integral);
+}
+
+static void *__buildIntegralImage(CTSInfo *info)
+{
+    return createIntegralImage(info->targetImage);
+}
+
+static void __freeIntegralImage(void *data)
+{
+    freeIntegralImage(data);
+}
+
+const IntegralImage *getIntegralImage(CTSInfo *info)
+{
+    return getFrameData(info, FrameIntegralData, &__buildIntegralImage, &__freeIntegralImage);
+}
+
+static inline void __windowSums(const IntegralImage *integral, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint32_t sum[3], uint64_t *energy)
+{
+    size_t stride = integral->width + 1;
+    const uint32_t *top = &integral->sums[y1 * stride * 3], *bottom = &integral->sums[y2 * stride * 3];
+    sum[0] = bottom[x2 * 3 + 0] - bottom[x1 * 3 + 0] - top[x2 * 3 + 0] + top[x1 * 3 + 0];
+    sum[1] = bottom[x2 * 3 + 1] - bottom[x1 * 3 + 1] - top[x2 * 3 + 1] + top[x1 * 3 + 1];
+    sum[2] = bottom[x2 * 3 + 2] - bottom[x1 * 3 + 2] - top[x2 * 3 + 2] + top[x1 * 3 + 2];
+    *energy = integral->energy[y2 * stride + x2] - integral->energy[y2 * stride + x1] - integral->energy[y1 * stride + x2] + integral->energy[y1 * stride + x1];
+}
+
+bool getRegionStats(CTSInfo *info, int32_t x1, int32_t y1, int32_t x2, int32_t y2, RegionStats *stats)
+{
+    const IntegralImage *integral = NULL;
+    uint32_t sum[3];
+    uint64_t energy;
+
+    memset(stats, 0, sizeof(RegionStats));
+    if (x2 <= x1 || y2 <= y1 || !(integral = getIntegralImage(info)))
+        return false;
+
+    __windowSums(integral, x1, y1, x2, y2, sum, &energy);
+    stats->count = (uint32_t)(x2 - x1) * (y2 - y1);
+    stats->mean[0] = (double)sum[0] / stats->count;
+    stats->mean[1] = (double)sum[1] / stats->count;
+    stats->mean[2] = (double)sum[2] / stats->count;
+    stats->variance = (double)energy / stats->count - (stats->mean[0] * stats->mean[0] + stats->mean[1] * stats->mean[1] + stats->mean[2] * stats->mean[2]);
+    if (stats->variance < 0.0)
+        stats->variance = 0.0;
+    return true;
+}
+
+/** Over a rectangle of A pixels whose pixels each differ by at most tol, the channel sums differ by at most A * tol
+ *  (per channel for CTS 0, in Euclidean distance for CTS 1) and, by the triangle inequality on the pixel vectors,
+ *  the square roots of the energies differ by at most sqrt(A) * tol (sqrt(3 * A) * tol for CTS 0). Exact matches
+ *  need equal sums and energies.
+ **/
+bool matchTemplateRegions(const TemplateRegions *regions, const IntegralImage *integral, int32_t x, int32_t y, int16_t CTSNum, uint16_t tolerance)
+{
+    uint32_t K, sum[3];
+    uint64_t energy;
+
+    if (CTSNum < -1 || CTSNum > 1)
+        return true;
+
+    for (K = 0; K < regions->count; ++K)
+    {
+        const TemplateRegion *region = &regions->regions[K];
+        int32_t X = x + region->x, Y = y + region->y;
+        int64_t area = (int64_t)region->width * region->height, bound = area * tolerance;
+
+        __windowSums(integral, X, Y, X + region->width, Y + region->height, sum, &energy);
+        int64_t R = (int64_t)sum[0] - region->sum[0], G = (int64_t)sum[1] - region->sum[1], B = (int64_t)sum[2] - region->sum[2];
+
+        if (CTSNum == -1)
+        {
+            if (R || G || B || energy != region->energy)
+                return false;
+            continue;
+        }
+
+        if (CTSNum == 0 ? (llabs(R) > bound || llabs(G) > bound || llabs(B) > bound) : (R * R + G * G + B * B > bound * bound))
+            return false;
+
+        double spread = sqrt((double)(CTSNum == 0 ? 3 * area : area)) * tolerance;
+        if (fabs(sqrt((double)energy) - sqrt((double)region->energy)) > spread + 1e-6)
+            return false;
+    }
+    return true;
+}
@@ -0,0 +1,289 @@
+#include "matchmask.h"
+
+#include <string.h>
+
+/** Masks smaller than this are filled on the calling thread. Larger ones are cut into a few row bands per thread. **/
+#define MASK_PARALLEL_MIN_PIXELS (256 * 256)
+#define MASK_BANDS_PER_THREAD 4
+
+typedef struct
+{
+    CTSInfo *info;
+    MatchMask *mask;
+    rgb32 *colour;
+    uint16_t tolerance;
+    uint32_t bands;
+} __MaskJob;
+
+static inline uint32_t *__maskRow(const MatchMask *mask, int32_t row)
+{
+    return &mask->bits[(size_t)row * mask->words];
+}
+
+/** The bits past x2 in a row's last word. They are kept clear so that counting and iterating never need to mask them. **/
+static inline uint32_t __tailMask(const MatchMask *mask)
+{
+    uint32_t used = (mask->x2 - mask->x1) & 31;
+    return used ? (1u << used) - 1 : UINT32_MAX;
+}
+
+static inline bool __sameArea(const MatchMask *mask, const MatchMask *other)
+{
+    return mask->x1 == other->x1 && mask->y1 == other->y1 && mask->x2 == other->x2 && mask->y2 == other->y2;
+}
+
+static inline size_t __maskWords(const MatchMask *mask)
+{
+    return (size_t)mask->words * (mask->y2 - mask->y1);
+}
+
+void initMatchMask(MatchMask *mask)
+{
+    mask->x1 = mask->y1 = mask->x2 = mask->y2 = 0;
+    mask->words = 0;
+    mask->bits = NULL;
+    mask->capacity = 0;
+}
+
+void freeMatchMask(MatchMask *mask)
+{
+    free(mask->bits);
+    initMatchMask(mask);
+}
+
+bool resizeMatchMask(MatchMask *mask, int32_t x1, int32_t y1, int32_t x2, int32_t y2)
+{
+    if (x2 <= x1 || y2 <= y1)
+        return false;
+
+    uint32_t words = ((uint32_t)(x2 - x1) + 31) / 32;
+    size_t size = (size_t)words * (uint32_t)(y2 - y1);
+
+    if (size > mask->capacity)
+    {
+        uint32_t *bits = malloc(size * sizeof(uint32_t));
+        if (!bits)
+            return false;
+
+        free(mask->bits);
+        mask->bits = bits;
+        mask->capacity = size;
+    }
+
+    mask->x1 = x1;
+    mask->y1 = y1;
+    mask->x2 = x2;
+    mask->y2 = y2;
+    mask->words = words;
+    memset(mask->bits, 0, size * sizeof(uint32_t));
+    return true;
+}
+
+static void __fillBand(void *data, uint32_t band)
+{
+    __MaskJob *job = data;
+    uint64_t rows = job->mask->y2 - job->mask->y1;
+    int32_t top = job->mask->y1 + (int32_t)(rows * band / job->bands);
+    int32_t bottom = job->mask->y1 + (int32_t)(rows * (band + 1) / job->bands);
+    maskColoursTolerance(job->info, &job->mask->bits[(size_t)(top - job->mask->y1) * job->mask->words], job->mask->words, job->colour, job->mask->x1, top, job->mask->x2, bottom, job->tolerance);
+}
+
+/** Bands own whole rows and rows start on fresh words, so bands never write to the same word. **/
+bool findColoursMask(CTSInfo *info, MatchMask *mask, rgb32 *colour, int32_t x1, int32_t y1, int32_t x2, int32_t y2, uint16_t tolerance)
+{
+    if (!resizeMatchMask(mask, x1, y1, x2, y2))
+        return false;
+
+    uint32_t threads = threadPoolSize(info->pool);
+    uint32_t rows = y2 - y1;
+    info->tol = tolerance;
+
+    if (threads < 2 || (uint64_t)(x2 - x1) * rows < MASK_PARALLEL_MIN_PIXELS)
+    {
+        maskColoursTolerance(info, mask->bits, mask->words, colour, x1, y1, x2, y2, tolerance);
+        return true;
+    }
+
+    __MaskJob job = {info, mask, colour, tolerance, rows < threads * MASK_BANDS_PER_THREAD ? rows : threads * MASK_BANDS_PER_THREAD};
+    parallelFor(info->pool, job.bands, &__fillBand, &job);
+    return true;
+}
+
+bool andMatchMask(MatchMask *mask, const MatchMask *other)
+{
+    size_t I, size = __maskWords(mask);
+    if (!__sameArea(mask, other))
+        return false;
+
+    for (I = 0; I < size; ++I)
+        mask->bits[I] &= other->bits[I];
+    return true;
+}
+
+bool orMatchMask(MatchMask *mask, const MatchMask *other)
+{
+    size_t I, size = __maskWords(mask);
+    if (!__sameArea(mask, other))
+        return false;
+
+    for (I = 0; I < size; ++I)
+        mask->bits[I] |= other->bits[I];
+    return true;
+}
+
+bool xorMatchMask(MatchMask *mask, const MatchMask *other)
+{
+    size_t I, size = __maskWords(mask);
+    if (!__sameArea(mask, other))
+        return false;
+
+    for (I = 0; I < size; ++I)
+        mask->bits[I] ^= other->bits[I];
+    return true;
+}
+
+void notMatchMask(MatchMask *mask)
+{
+    size_t I, size = __maskWords(mask);
+    uint32_t tail = __tailMask(mask);
+
+    for (I = 0; I < size; ++I)
+        mask->bits[I] = ~mask->bits[I];
+    for (I = mask->words - 1; I < size; I += mask->words)
+        mask->bits[I] &= tail;
+}
+
+/** Grows every set bit of a row by one pixel to each side, carrying bits across word boundaries. **/
+static void __growRow(uint32_t *bits, uint32_t words, uint32_t tail)
+{
+    uint32_t I, carry = 0;
+    for (I = 0; I < words; ++I)
+    {
+        uint32_t word = bits[I];
+        uint32_t next = I + 1 < words ? bits[I + 1] : 0;
+        bits[I] = word | (word << 1) | carry | (word >> 1) | (next << 31);
+        carry = word >> 31;
+    }
+    bits[words - 1] &= tail;
+}
+
+/** The square is separable: rows are grown sideways first, then each row takes the union of the grown rows within
+ *  radius of it. Those rows are read from a copy of the mask so that rows already updated do not spread further.
+ **/
+bool dilateMatchMask(MatchMask *mask, uint32_t radius)
+{
+    int32_t I, J, rows = mask->y2 - mask->y1, width = mask->x2 - mask->x1;
+    size_t K, size = __maskWords(mask);
+    uint32_t tail = __tailMask(mask);
+
+    if (!radius || !size)
+        return true;
+
+    uint32_t *copy = malloc(size * sizeof(uint32_t));
+    if (!copy)
+        return false;
+
+    int32_t across = radius < (uint32_t)width ? (int32_t)radius : width;
+    int32_t down = radius < (uint32_t)rows ? (int32_t)radius : rows;
+
+    for (I = 0; I < rows; ++I)
+    {
+        for (J = 0; J < across; ++J)
+            __growRow(__maskRow(mask, I), mask->words, tail);
+    }
+
+    memcpy(copy, mask->bits, size * sizeof(uint32_t));
+    for (I = 0; I < rows; ++I)
+    {
+        uint32_t *bits = __maskRow(mask, I);
+        int32_t top = I - down > 0 ? I - down : 0;
+        int32_t bottom = I + down + 1 < rows ? I + down + 1 : rows;
+
+        for (J = top; J < bottom; ++J)
+        {
+            const uint32_t *source = &copy[(size_t)J * mask->words];
+            for (K = 0; K < mask->words; ++K)
+                bits[K] |= source[K];
+        }
+    }
+
+    free(copy);
+    return true;
+}
+
+uint64_t countMatchMask(const MatchMask *mask)
+{
+    size_t I, size = __maskWords(mask);
+    uint64_t Result = 0;
+
+    for (I = 0; I < size; ++I)
+        Result += __builtin_popcount(mask->bits[I]);
+    return Result;
+}
+
+bool matchMaskBounds(const MatchMask *mask, int32_t *x1, int32_t *y1, int32_t *x2, int32_t *y2)
+{
+    int32_t I, rows = mask->y2 - mask->y1;
+    uint32_t J, left = UINT32_MAX, right = 0;
+    int32_t top = -1, bottom = -1;
+
+    for (I = 0; I < rows; ++I)
+    {
+        const uint32_t *bits = __maskRow(mask, I);
+        for (J = 0; J < mask->words; ++J)
+        {
+            if (!bits[J])
+                continue;
+
+            uint32_t first = J * 32 + __builtin_ctz(bits[J]);
+            left = first < left ? first : left;
+            break;
+        }
+
+        if (J == mask->words)
+            continue;
+
+        for (J = mask->words; J-- > 0;)
+        {
+            if (!bits[J])
+                continue;
+
+            uint32_t last = J * 32 + 31 - __builtin_clz(bits[J]);
+            right = last > right ? last : right;
+            break;
+        }
+
+        top = top < 0 ? I : top;
+        bottom = I;
+    }
+
+    if (top < 0)
+        return false;
+
+    *x1 = mask->x1 + (int32_t)left;
+    *y1 = mask->y1 + top;
+    *x2 = mask->x1 + (int32_t)right + 1;
+    *y2 = mask->y1 + bottom + 1;
+    return true;
+}
+
+bool matchMaskPoints(const MatchMask *mask, PointArray *points)
+{
+    int32_t I, rows = mask->y2 - mask->y1;
+    uint32_t J;
+
+    for (I = 0; I < rows; ++I)
+    {
+        const uint32_t *bits = __maskRow(mask, I);
+        for (J = 0; J < mask->words; ++J)
+        {
+            uint32_t word;
+            for (word = bits[J]; word; word &= word - 1)
+            {
+                if (!appendPoint(points, mask->x1 + (int32_t)(J * 32) + __builtin_ctz(word), mask->y1 + I))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,81 @@
+#include "points.h"
+
+#include <string.h>
+
+void initPointArray(PointArray* pa)
+{
+    pa->p = NULL;
+    pa->size = 0;
+    pa->capacity = 0;
+    pa->fixed = false;
+}
+
+void initFixedPointArray(PointArray* pa, Point *points, size_t capacity)
+{
+    pa->p = points;
+    pa->size = 0;
+    pa->capacity = capacity;
+    pa->fixed = true;
+}
+
+void freePointArray(PointArray* pa)
+{
+    if (!pa->fixed)
+        free(pa->p);
+
+    initPointArray(pa);
+}
+
+void clearPointArray(PointArray* pa)
+{
+    pa->size = 0;
+}
+
+bool reservePointArray(PointArray* pa, size_t capacity)
+{
+    if (capacity <= pa->capacity)
+        return true;
+
+    if (pa->fixed)
+        return false;
+
+    Point *loc = realloc(pa->p, capacity * sizeof(Point));
+    if (!loc)
+        return false;
+
+    pa->p = loc;
+    pa->capacity = capacity;
+    return true;
+}
+
+static bool __growPointArray(PointArray* pa, size_t required)
+{
+    size_t capacity = pa->capacity < 16 ? 16 : pa->capacity;
+    while (capacity < required)
+        capacity += capacity / 2;
+    return reservePointArray(pa, capacity);
+}
+
+bool appendPoint(PointArray* pa, int32_t x, int32_t y)
+{
+    if (pa->size == pa->capacity && !__growPointArray(pa, pa->size + 1))
+        return false;
+
+    pa->p[pa->size].x = x;
+    pa->p[pa->size].y = y;
+    ++pa->size;
+    return true;
+}
+
+bool appendPoints(PointArray* pa, const Point *points, size_t count)
+{
+    if (count == 0)
+        return true;
+
+    if (pa->size + count > pa->capacity && !__growPointArray(pa, pa->size + count))
+        return false;
+
+    memcpy(&pa->p[pa->size], points, count * sizeof(Point));
+    pa->size += count;
+    return true;
+}
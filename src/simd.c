@@ -0,0 +1,500 @@
+#include "simd.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef SIMD_X86
+#include <immintrin.h>
+#endif // SIMD_X86
+
+#define TARGET(isa) __attribute__((target(isa)))
+
+/** Tolerances past these values match every pixel. Clamping keeps tol * tol within a signed 32-bit lane. **/
+#define CTS0_MAX_TOL 255
+#define CTS1_MAX_TOL 442
+
+static inline bool __matchCTSN(const rgb32 *px, const rgb32 *colour, uint32_t tol)
+{
+    return (px->r == colour->r) && (px->g == colour->g) && (px->b == colour->b);
+}
+
+static inline bool __matchCTS0(const rgb32 *px, const rgb32 *colour, uint32_t tol)
+{
+    return abs(px->r - colour->r) <= tol && abs(px->g - colour->g) <= tol && abs(px->b - colour->b) <= tol;
+}
+
+static inline bool __matchCTS1(const rgb32 *px, const rgb32 *colour, uint32_t tol)
+{
+    int32_t R = px->r - colour->r, G = px->g - colour->g, B = px->b - colour->b;
+    return (uint32_t)(R * R + G * G + B * B) <= tol * tol;
+}
+
+#define DEFINE_SCALAR_KERNELS(CTS) \
+static uint32_t __scalarCount##CTS(const rgb32 *row, uint32_t count, const rgb32 *colour, uint16_t tol) \
+{ \
+    uint32_t I, Result = 0; \
+    for (I = 0; I < count; ++I) \
+        Result += __match##CTS(&row[I], colour, tol); \
+    return Result; \
+} \
+\
+static int32_t __scalarFind##CTS(const rgb32 *row, uint32_t count, const rgb32 *colour, uint16_t tol) \
+{ \
+    uint32_t I; \
+    for (I = 0; I < count; ++I) \
+        if (__match##CTS(&row[I], colour, tol)) \
+            return I; \
+    return -1; \
+} \
+\
+static uint32_t __scalarMaskFrom##CTS(const rgb32 *row, uint32_t start, uint32_t count, const rgb32 *colour, uint16_t tol, uint32_t *bits) \
+{ \
+    uint32_t I, Result = 0; \
+    for (I = start; I < count; ++I) \
+    { \
+        if (__match##CTS(&row[I], colour, tol)) \
+        { \
+            bits[I >> 5] |= 1u << (I & 31); \
+            ++Result; \
+        } \
+    } \
+    return Result; \
+} \
+\
+static uint32_t __scalarMask##CTS(const rgb32 *row, uint32_t count, const rgb32 *colour, uint16_t tol, uint32_t *bits) \
+{ \
+    memset(bits, 0, ((count + 31) / 32) * sizeof(uint32_t)); \
+    return __scalarMaskFrom##CTS(row, 0, count, colour, tol, bits); \
+}
+
+DEFINE_SCALAR_KERNELS(CTSN)
+DEFINE_SCALAR_KERNELS(CTS0)
+DEFINE_SCALAR_KERNELS(CTS1)
+
+static uint32_t __scalarSSD(const rgb32 *first, const rgb32 *second, uint32_t count)
+{
+    uint32_t I, Result = 0;
+    for (I = 0; I < count; ++I)
+    {
+        int32_t R = first[I].r - second[I].r, G = first[I].g - second[I].g, B = first[I].b - second[I].b;
+        Result += R * R + G * G + B * B;
+    }
+    return Result;
+}
+
+static uint32_t __scalarSAD(const rgb32 *first, const rgb32 *second, uint32_t count)
+{
+    uint32_t I, Result = 0;
+    for (I = 0; I < count; ++I)
+        Result += abs(first[I].r - second[I].r) + abs(first[I].g - second[I].g) + abs(first[I].b - second[I].b);
+    return Result;
+}
+
+
+/** Generates the row kernels of one instruction set from a block function that matches WIDTH pixels at a time.
+ *  WIDTH must divide 32 so that a block never straddles two words of the bit mask.
+ **/
+#define DEFINE_SIMD_KERNELS(ISA, CTS, WIDTH, TARGET_ISA, STATE, INIT, BLOCK) \
+TARGET(TARGET_ISA) static uint32_t __##ISA##Count##CTS(const rgb32 *row, uint32_t count, const rgb32 *colour, uint16_t tol) \
+{ \
+    STATE state = INIT(colour, tol); \
+    uint32_t I = 0, Result = 0; \
+    for (; I + WIDTH <= count; I += WIDTH) \
+        Result += __builtin_popcount(BLOCK(&state, &row[I])); \
+    return Result + __scalarCount##CTS(&row[I], count - I, colour, tol); \
+} \
+\
+TARGET(TARGET_ISA) static int32_t __##ISA##Find##CTS(const rgb32 *row, uint32_t count, const rgb32 *colour, uint16_t tol) \
+{ \
+    STATE state = INIT(colour, tol); \
+    uint32_t I = 0, Mask; \
+    for (; I + WIDTH <= count; I += WIDTH) \
+        if ((Mask = BLOCK(&state, &row[I]))) \
+            return I + __builtin_ctz(Mask); \
+    int32_t Result = __scalarFind##CTS(&row[I], count - I, colour, tol); \
+    return Result < 0 ? -1 : (int32_t)I + Result; \
+} \
+\
+TARGET(TARGET_ISA) static uint32_t __##ISA##Mask##CTS(const rgb32 *row, uint32_t count, const rgb32 *colour, uint16_t tol, uint32_t *bits) \
+{ \
+    STATE state = INIT(colour, tol); \
+    uint32_t I = 0, Mask, Result = 0; \
+    memset(bits, 0, ((count + 31) / 32) * sizeof(uint32_t)); \
+    for (; I + WIDTH <= count; I += WIDTH) \
+    { \
+        Mask = BLOCK(&state, &row[I]); \
+        bits[I >> 5] |= Mask << (I & 31); \
+        Result += __builtin_popcount(Mask); \
+    } \
+    return Result + __scalarMaskFrom##CTS(row, I, count, colour, tol, bits); \
+}
+
+
+#ifdef SIMD_X86
+
+/******************************** SSE2 - 8 pixels per block ********************************/
+
+typedef struct
+{
+    __m128i colour;
+    __m128i tol;
+    __m128i tolSq;
+} __sse2State;
+
+TARGET("sse2") static inline __sse2State __sse2Init(const rgb32 *colour, uint16_t tol)
+{
+    uint32_t c;
+    memcpy(&c, colour, sizeof(c));
+    uint32_t t0 = tol > CTS0_MAX_TOL ? CTS0_MAX_TOL : tol;
+    uint32_t t1 = tol > CTS1_MAX_TOL ? CTS1_MAX_TOL : tol;
+
+    __sse2State state;
+    state.colour = _mm_set1_epi32(c & 0x00FFFFFF);
+    state.tol = _mm_set1_epi8((char)t0);
+    state.tolSq = _mm_set1_epi32(t1 * t1);
+    return state;
+}
+
+TARGET("sse2") static inline __m128i __sse2AbsDiff(__m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_subs_epu8(a, b), _mm_subs_epu8(b, a));
+}
+
+TARGET("sse2") static inline uint32_t __sse2Movemask(__m128i lo, __m128i hi)
+{
+    return _mm_movemask_ps(_mm_castsi128_ps(lo)) | (_mm_movemask_ps(_mm_castsi128_ps(hi)) << 4);
+}
+
+TARGET("sse2") static inline __m128i __sse2CTSN(const __sse2State *state, __m128i px)
+{
+    return _mm_cmpeq_epi32(_mm_and_si128(px, _mm_set1_epi32(0x00FFFFFF)), state->colour);
+}
+
+TARGET("sse2") static inline __m128i __sse2CTS0(const __sse2State *state, __m128i px)
+{
+    __m128i over = _mm_subs_epu8(__sse2AbsDiff(px, state->colour), state->tol);
+    return _mm_cmpeq_epi32(_mm_and_si128(over, _mm_set1_epi32(0x00FFFFFF)), _mm_setzero_si128());
+}
+
+TARGET("sse2") static inline __m128i __sse2CTS1(const __sse2State *state, __m128i px)
+{
+    __m128i diff = __sse2AbsDiff(px, state->colour);
+    __m128i rb = _mm_and_si128(diff, _mm_set1_epi32(0x00FF00FF));
+    __m128i g = _mm_and_si128(_mm_srli_epi32(diff, 8), _mm_set1_epi32(0x000000FF));
+    __m128i dist = _mm_add_epi32(_mm_madd_epi16(rb, rb), _mm_madd_epi16(g, g));
+    return _mm_xor_si128(_mm_cmpgt_epi32(dist, state->tolSq), _mm_set1_epi32(-1));
+}
+
+#define DEFINE_SSE2_BLOCK(CTS) \
+TARGET("sse2") static inline uint32_t __sse2Block##CTS(const __sse2State *state, const rgb32 *px) \
+{ \
+    __m128i lo = __sse2##CTS(state, _mm_loadu_si128((const __m128i *)px)); \
+    __m128i hi = __sse2##CTS(state, _mm_loadu_si128((const __m128i *)(px + 4))); \
+    return __sse2Movemask(lo, hi); \
+}
+
+DEFINE_SSE2_BLOCK(CTSN)
+DEFINE_SSE2_BLOCK(CTS0)
+DEFINE_SSE2_BLOCK(CTS1)
+
+/** Pixels are widened to 16-bit lanes with alpha cleared so one madd squares and pairs up the channel differences. **/
+TARGET("sse2") static uint32_t __sse2SSD(const rgb32 *first, const rgb32 *second, uint32_t count)
+{
+    uint32_t I, Result;
+    __m128i mask = _mm_set1_epi32(0x00FFFFFF), zero = _mm_setzero_si128(), sum = zero;
+
+    for (I = 0; I + 4 <= count; I += 4)
+    {
+        __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *)(first + I)), mask);
+        __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i *)(second + I)), mask);
+        __m128i lo = _mm_sub_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero));
+        __m128i hi = _mm_sub_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero));
+        sum = _mm_add_epi32(sum, _mm_add_epi32(_mm_madd_epi16(lo, lo), _mm_madd_epi16(hi, hi)));
+    }
+
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    Result = _mm_cvtsi128_si32(sum);
+    return Result + __scalarSSD(first + I, second + I, count - I);
+}
+
+TARGET("sse2") static uint32_t __sse2SAD(const rgb32 *first, const rgb32 *second, uint32_t count)
+{
+    uint32_t I;
+    __m128i mask = _mm_set1_epi32(0x00FFFFFF), sum = _mm_setzero_si128();
+
+    for (I = 0; I + 4 <= count; I += 4)
+    {
+        __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *)(first + I)), mask);
+        __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i *)(second + I)), mask);
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(a, b));
+    }
+
+    uint32_t Result = _mm_cvtsi128_si32(sum) + _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+    return Result + __scalarSAD(first + I, second + I, count - I);
+}
+
+DEFINE_SIMD_KERNELS(sse2, CTSN, 8, "sse2", __sse2State, __sse2Init, __sse2BlockCTSN)
+DEFINE_SIMD_KERNELS(sse2, CTS0, 8, "sse2", __sse2State, __sse2Init, __sse2BlockCTS0)
+DEFINE_SIMD_KERNELS(sse2, CTS1, 8, "sse2", __sse2State, __sse2Init, __sse2BlockCTS1)
+
+
+/******************************** AVX2 - 16 pixels per block ********************************/
+
+typedef struct
+{
+    __m256i colour;
+    __m256i tol;
+    __m256i tolSq;
+} __avx2State;
+
+TARGET("avx2") static inline __avx2State __avx2Init(const rgb32 *colour, uint16_t tol)
+{
+    uint32_t c;
+    memcpy(&c, colour, sizeof(c));
+    uint32_t t0 = tol > CTS0_MAX_TOL ? CTS0_MAX_TOL : tol;
+    uint32_t t1 = tol > CTS1_MAX_TOL ? CTS1_MAX_TOL : tol;
+
+    __avx2State state;
+    state.colour = _mm256_set1_epi32(c & 0x00FFFFFF);
+    state.tol = _mm256_set1_epi8((char)t0);
+    state.tolSq = _mm256_set1_epi32(t1 * t1);
+    return state;
+}
+
+TARGET("avx2") static inline __m256i __avx2AbsDiff(__m256i a, __m256i b)
+{
+    return _mm256_or_si256(_mm256_subs_epu8(a, b), _mm256_subs_epu8(b, a));
+}
+
+TARGET("avx2") static inline uint32_t __avx2Movemask(__m256i lo, __m256i hi)
+{
+    return _mm256_movemask_ps(_mm256_castsi256_ps(lo)) | (_mm256_movemask_ps(_mm256_castsi256_ps(hi)) << 8);
+}
+
+TARGET("avx2") static inline __m256i __avx2CTSN(const __avx2State *state, __m256i px)
+{
+    return _mm256_cmpeq_epi32(_mm256_and_si256(px, _mm256_set1_epi32(0x00FFFFFF)), state->colour);
+}
+
+TARGET("avx2") static inline __m256i __avx2CTS0(const __avx2State *state, __m256i px)
+{
+    __m256i over = _mm256_subs_epu8(__avx2AbsDiff(px, state->colour), state->tol);
+    return _mm256_cmpeq_epi32(_mm256_and_si256(over, _mm256_set1_epi32(0x00FFFFFF)), _mm256_setzero_si256());
+}
+
+TARGET("avx2") static inline __m256i __avx2CTS1(const __avx2State *state, __m256i px)
+{
+    __m256i diff = __avx2AbsDiff(px, state->colour);
+    __m256i rb = _mm256_and_si256(diff, _mm256_set1_epi32(0x00FF00FF));
+    __m256i g = _mm256_and_si256(_mm256_srli_epi32(diff, 8), _mm256_set1_epi32(0x000000FF));
+    __m256i dist = _mm256_add_epi32(_mm256_madd_epi16(rb, rb), _mm256_madd_epi16(g, g));
+    return _mm256_xor_si256(_mm256_cmpgt_epi32(dist, state->tolSq), _mm256_set1_epi32(-1));
+}
+
+#define DEFINE_AVX2_BLOCK(CTS) \
+TARGET("avx2") static inline uint32_t __avx2Block##CTS(const __avx2State *state, const rgb32 *px) \
+{ \
+    __m256i lo = __avx2##CTS(state, _mm256_loadu_si256((const __m256i *)px)); \
+    __m256i hi = __avx2##CTS(state, _mm256_loadu_si256((const __m256i *)(px + 8))); \
+    return __avx2Movemask(lo, hi); \
+}
+
+DEFINE_AVX2_BLOCK(CTSN)
+DEFINE_AVX2_BLOCK(CTS0)
+DEFINE_AVX2_BLOCK(CTS1)
+
+TARGET("avx2") static uint32_t __avx2SSD(const rgb32 *first, const rgb32 *second, uint32_t count)
+{
+    uint32_t I;
+    __m256i mask = _mm256_set1_epi32(0x00FFFFFF), zero = _mm256_setzero_si256(), sum = zero;
+
+    for (I = 0; I + 8 <= count; I += 8)
+    {
+        __m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(first + I)), mask);
+        __m256i b = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(second + I)), mask);
+        __m256i lo = _mm256_sub_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero));
+        __m256i hi = _mm256_sub_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero));
+        sum = _mm256_add_epi32(sum, _mm256_add_epi32(_mm256_madd_epi16(lo, lo), _mm256_madd_epi16(hi, hi)));
+    }
+
+    __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+    half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+    uint32_t Result = _mm_cvtsi128_si32(half);
+    return Result + __scalarSSD(first + I, second + I, count - I);
+}
+
+TARGET("avx2") static uint32_t __avx2SAD(const rgb32 *first, const rgb32 *second, uint32_t count)
+{
+    uint32_t I;
+    __m256i mask = _mm256_set1_epi32(0x00FFFFFF), sum = _mm256_setzero_si256();
+
+    for (I = 0; I + 8 <= count; I += 8)
+    {
+        __m256i a = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(first + I)), mask);
+        __m256i b = _mm256_and_si256(_mm256_loadu_si256((const __m256i *)(second + I)), mask);
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(a, b));
+    }
+
+    __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+    uint32_t Result = _mm_cvtsi128_si32(half) + _mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+    return Result + __scalarSAD(first + I, second + I, count - I);
+}
+
+DEFINE_SIMD_KERNELS(avx2, CTSN, 16, "avx2", __avx2State, __avx2Init, __avx2BlockCTSN)
+DEFINE_SIMD_KERNELS(avx2, CTS0, 16, "avx2", __avx2State, __avx2Init, __avx2BlockCTS0)
+DEFINE_SIMD_KERNELS(avx2, CTS1, 16, "avx2", __avx2State, __avx2Init, __avx2BlockCTS1)
+
+
+/******************************** AVX-512 - 16 pixels per block ********************************/
+
+typedef struct
+{
+    __m512i colour;
+    __m512i tol;
+    __m512i tolSq;
+} __avx512State;
+
+TARGET("avx512f,avx512bw") static inline __avx512State __avx512Init(const rgb32 *colour, uint16_t tol)
+{
+    uint32_t c;
+    memcpy(&c, colour, sizeof(c));
+    uint32_t t0 = tol > CTS0_MAX_TOL ? CTS0_MAX_TOL : tol;
+    uint32_t t1 = tol > CTS1_MAX_TOL ? CTS1_MAX_TOL : tol;
+
+    __avx512State state;
+    state.colour = _mm512_set1_epi32(c & 0x00FFFFFF);
+    state.tol = _mm512_set1_epi8((char)t0);
+    state.tolSq = _mm512_set1_epi32(t1 * t1);
+    return state;
+}
+
+TARGET("avx512f,avx512bw") static inline __m512i __avx512AbsDiff(__m512i a, __m512i b)
+{
+    return _mm512_sub_epi8(_mm512_max_epu8(a, b), _mm512_min_epu8(a, b));
+}
+
+TARGET("avx512f,avx512bw") static inline uint32_t __avx512BlockCTSN(const __avx512State *state, const rgb32 *px)
+{
+    __m512i p = _mm512_and_si512(_mm512_loadu_si512(px), _mm512_set1_epi32(0x00FFFFFF));
+    return _mm512_cmpeq_epi32_mask(p, state->colour);
+}
+
+TARGET("avx512f,avx512bw") static inline uint32_t __avx512BlockCTS0(const __avx512State *state, const rgb32 *px)
+{
+    __m512i over = _mm512_subs_epu8(__avx512AbsDiff(_mm512_loadu_si512(px), state->colour), state->tol);
+    return _mm512_testn_epi32_mask(over, _mm512_set1_epi32(0x00FFFFFF));
+}
+
+TARGET("avx512f,avx512bw") static inline uint32_t __avx512BlockCTS1(const __avx512State *state, const rgb32 *px)
+{
+    __m512i diff = __avx512AbsDiff(_mm512_loadu_si512(px), state->colour);
+    __m512i rb = _mm512_and_si512(diff, _mm512_set1_epi32(0x00FF00FF));
+    __m512i g = _mm512_and_si512(_mm512_srli_epi32(diff, 8), _mm512_set1_epi32(0x000000FF));
+    __m512i dist = _mm512_add_epi32(_mm512_madd_epi16(rb, rb), _mm512_madd_epi16(g, g));
+    return _mm512_cmple_epi32_mask(dist, state->tolSq);
+}
+
+DEFINE_SIMD_KERNELS(avx512, CTSN, 16, "avx512f,avx512bw", __avx512State, __avx512Init, __avx512BlockCTSN)
+DEFINE_SIMD_KERNELS(avx512, CTS0, 16, "avx512f,avx512bw", __avx512State, __avx512Init, __avx512BlockCTS0)
+DEFINE_SIMD_KERNELS(avx512, CTS1, 16, "avx512f,avx512bw", __avx512State, __avx512Init, __avx512BlockCTS1)
+
+#endif // SIMD_X86
+
+
+#define KERNEL_SET(ISA, CTS) {&__##ISA##Count##CTS, &__##ISA##Find##CTS, &__##ISA##Mask##CTS}
+
+static const SIMDKernels __scalarKernels[3] = {KERNEL_SET(scalar, CTSN), KERNEL_SET(scalar, CTS0), KERNEL_SET(scalar, CTS1)};
+
+#ifdef SIMD_X86
+static const SIMDKernels __sse2Kernels[3] = {KERNEL_SET(sse2, CTSN), KERNEL_SET(sse2, CTS0), KERNEL_SET(sse2, CTS1)};
+static const SIMDKernels __avx2Kernels[3] = {KERNEL_SET(avx2, CTSN), KERNEL_SET(avx2, CTS0), KERNEL_SET(avx2, CTS1)};
+static const SIMDKernels __avx512Kernels[3] = {KERNEL_SET(avx512, CTSN), KERNEL_SET(avx512, CTS0), KERNEL_SET(avx512, CTS1)};
+#endif // SIMD_X86
+
+/** Difference sums gain little from wider vectors than AVX2, so AVX-512 shares its kernels. **/
+static const SIMDDiffKernels __scalarDiffKernels = {&__scalarSSD, &__scalarSAD};
+
+#ifdef SIMD_X86
+static const SIMDDiffKernels __sse2DiffKernels = {&__sse2SSD, &__sse2SAD};
+static const SIMDDiffKernels __avx2DiffKernels = {&__avx2SSD, &__avx2SAD};
+#endif // SIMD_X86
+
+static SIMDLevel __supportedLevel = SIMDNone;
+static SIMDLevel __activeLevel = SIMDNone;
+static const SIMDKernels *__activeKernels = __scalarKernels;
+static const SIMDDiffKernels *__activeDiffKernels = &__scalarDiffKernels;
+
+__attribute__((constructor)) static void __detectSIMDLevel(void)
+{
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw"))
+        __supportedLevel = SIMDAVX512;
+    else if (__builtin_cpu_supports("avx2"))
+        __supportedLevel = SIMDAVX2;
+    else if (__builtin_cpu_supports("sse2"))
+        __supportedLevel = SIMDSSE2;
+#endif // SIMD_X86
+
+    setSIMDLevel(__supportedLevel);
+}
+
+SIMDLevel getSupportedSIMDLevel(void)
+{
+    return __supportedLevel;
+}
+
+SIMDLevel getSIMDLevel(void)
+{
+    return __activeLevel;
+}
+
+SIMDLevel setSIMDLevel(SIMDLevel level)
+{
+    if (level > __supportedLevel)
+        level = __supportedLevel;
+
+    switch(level)
+    {
+#ifdef SIMD_X86
+        case SIMDAVX512:
+            __activeKernels = __avx512Kernels;
+            __activeDiffKernels = &__avx2DiffKernels;
+            break;
+
+        case SIMDAVX2:
+            __activeKernels = __avx2Kernels;
+            __activeDiffKernels = &__avx2DiffKernels;
+            break;
+
+        case SIMDSSE2:
+            __activeKernels = __sse2Kernels;
+            __activeDiffKernels = &__sse2DiffKernels;
+            break;
+#endif // SIMD_X86
+
+        default:
+            level = SIMDNone;
+            __activeKernels = __scalarKernels;
+            __activeDiffKernels = &__scalarDiffKernels;
+            break;
+    }
+
+    __activeLevel = level;
+    return level;
+}
+
+const SIMDKernels *getSIMDKernels(int16_t CTSNum)
+{
+    if (CTSNum < -1 || CTSNum > 1)
+        return NULL;
+    return &__activeKernels[CTSNum + 1];
+}
+
+const SIMDDiffKernels *getSIMDDiffKernels(void)
+{
+    return __activeDiffKernels;
+}
@@ -60,6 +60,7 @@ TargetData getTargetData(Target *target, uint32_t x, uint32_t y, uint32_t width,
     {
     case RawKind:
         data.data = target->rawData.data;
+        break;
     case EIOSKind:
         if (target->eiosData.client->updateImageBufferBox != NULL)
             target->eiosData.client->updateImageBufferBox(target->eiosData.target, x, y, x + width, y + height);
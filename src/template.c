@@ -0,0 +1,361 @@
+#include "template.h"
+
+/** Sums the pixels of a factor x factor block. Returns false if any of them is transparent. **/
+static bool __blockSum(bitmap *image, uint32_t X, uint32_t Y, uint32_t factor, BlockSum *sum)
+{
+    uint32_t I, J, R = 0, G = 0, B = 0;
+    for (I = Y; I < Y + factor; ++I)
+    {
+        for (J = X; J < X + factor; ++J)
+        {
+            rgb32 *pixel = &image->pixels[I * image->width + J];
+            if (pixel->a == 0)
+                return false;
+
+            R += pixel->r;
+            G += pixel->g;
+            B += pixel->b;
+        }
+    }
+
+    sum->r = R;
+    sum->g = G;
+    sum->b = B;
+    sum->a = 0;
+    return true;
+}
+
+/** For the alignment (PX, PY) = (x % F, y % F), template block (BX, BY) covers the pixels starting at
+ *  (F * BX - PX, F * BY - PY) and lines up with the target block (x / F + BX, y / F + BY).
+ *  Only blocks that lie completely inside the template and are fully opaque bound the comparison.
+ **/
+static bool __createTemplateLevel(TemplateLevel *level, bitmap *image, uint32_t factor)
+{
+    uint32_t PX, PY, BX, BY, count = 0;
+    uint32_t blocksX = image->width / factor + 1, blocksY = image->height / factor + 1;
+
+    level->factor = factor;
+    if (!(level->blocks = malloc(factor * factor * blocksX * blocksY * sizeof(TemplateBlock))))
+        return false;
+
+    for (PY = 0; PY < factor; ++PY)
+    {
+        for (PX = 0; PX < factor; ++PX)
+        {
+            level->offsets[PY * factor + PX] = count;
+            for (BY = PY ? 1 : 0; factor * (BY + 1) - PY <= image->height; ++BY)
+            {
+                for (BX = PX ? 1 : 0; factor * (BX + 1) - PX <= image->width; ++BX)
+                {
+                    TemplateBlock *block = &level->blocks[count];
+                    if (__blockSum(image, factor * BX - PX, factor * BY - PY, factor, &block->sum))
+                    {
+                        block->x = BX;
+                        block->y = BY;
+                        ++count;
+                    }
+                }
+            }
+        }
+    }
+
+    level->offsets[factor * factor] = count;
+    return true;
+}
+
+/** Colours are binned at 4 bits per channel so that noise does not make every pixel unique. **/
+#define ANCHOR_BIN(px) ((((px)->r >> 4) << 8) | (((px)->g >> 4) << 4) | ((px)->b >> 4))
+#define ANCHOR_BINS 4096
+
+typedef struct
+{
+    uint32_t rank;
+    uint32_t frequency;
+    int32_t distance;
+    uint32_t index;
+} __Anchor;
+
+static int __compareAnchors(const void *first, const void *second)
+{
+    const __Anchor *a = first, *b = second;
+    if (a->rank != b->rank)
+        return a->rank < b->rank ? -1 : 1;
+    if (a->frequency != b->frequency)
+        return a->frequency < b->frequency ? -1 : 1;
+    if (a->distance != b->distance)
+        return a->distance > b->distance ? -1 : 1;
+    return a->index < b->index ? -1 : 1;
+}
+
+/** Orders the opaque pixels by how many pixels share their colour bin, rarest first, breaking ties by the distance
+ *  from the image's mean colour. One pixel of every bin is taken before the second of any, so that consecutive
+ *  anchors do not all test the same colour.
+ **/
+static bool __orderAnchors(Template *tpl, bitmap *image)
+{
+    uint32_t I, K = 0, total = image->width * image->height;
+    uint64_t R = 0, G = 0, B = 0;
+    uint32_t *frequency = calloc(ANCHOR_BINS, sizeof(uint32_t));
+    __Anchor *anchors = malloc(total * sizeof(__Anchor) + 1);
+    tpl->order = malloc(total * sizeof(uint32_t) + 1);
+    tpl->count = 0;
+
+    if (!frequency || !anchors || !tpl->order)
+    {
+        free(frequency);
+        free(anchors);
+        return false;
+    }
+
+    for (I = 0; I < total; ++I)
+    {
+        rgb32 *pixel = &image->pixels[I];
+        if (pixel->a != 0)
+        {
+            ++frequency[ANCHOR_BIN(pixel)];
+            R += pixel->r;
+            G += pixel->g;
+            B += pixel->b;
+            ++tpl->count;
+        }
+    }
+
+    for (I = 0; I < total && tpl->count; ++I)
+    {
+        rgb32 *pixel = &image->pixels[I];
+        if (pixel->a != 0)
+        {
+            int32_t dR = pixel->r - (int32_t)(R / tpl->count), dG = pixel->g - (int32_t)(G / tpl->count), dB = pixel->b - (int32_t)(B / tpl->count);
+            __Anchor anchor = {0, frequency[ANCHOR_BIN(pixel)], dR * dR + dG * dG + dB * dB, I};
+            anchors[K++] = anchor;
+        }
+    }
+
+    /** The first pass sorts every bin's pixels by distance; the second interleaves the bins by rank. **/
+    qsort(anchors, tpl->count, sizeof(__Anchor), &__compareAnchors);
+    memset(frequency, 0, ANCHOR_BINS * sizeof(uint32_t));
+    for (I = 0; I < tpl->count; ++I)
+        anchors[I].rank = frequency[ANCHOR_BIN(&image->pixels[anchors[I].index])]++;
+
+    qsort(anchors, tpl->count, sizeof(__Anchor), &__compareAnchors);
+    for (I = 0; I < tpl->count; ++I)
+        tpl->order[I] = anchors[I].index;
+
+    free(frequency);
+    free(anchors);
+    return true;
+}
+
+static int __compareRegions(const void *first, const void *second)
+{
+    const TemplateRegion *a = first, *b = second;
+    uint64_t areaA = (uint64_t)a->width * a->height, areaB = (uint64_t)b->width * b->height;
+    return areaA != areaB ? (areaA > areaB ? -1 : 1) : (a->y != b->y ? a->y - b->y : a->x - b->x);
+}
+
+/** Greedily grows a rectangle from every unclaimed opaque pixel, first along its row and then down for as long as
+ *  the whole span stays opaque and unclaimed. Only the largest rectangles are kept.
+ **/
+bool createTemplateRegions(TemplateRegions *regions, bitmap *image)
+{
+    uint32_t I, J, X, Y, width, height, found = 0;
+    bool *claimed = calloc(image->width * image->height + 1, sizeof(bool));
+    TemplateRegion candidates[TEMPLATE_REGIONS];
+
+    regions->count = 0;
+    if (!claimed)
+        return false;
+
+    for (I = 0; I < image->height; ++I)
+    {
+        for (J = 0; J < image->width; ++J)
+        {
+            if (claimed[I * image->width + J] || image->pixels[I * image->width + J].a == 0)
+                continue;
+
+            for (width = 1; J + width < image->width && !claimed[I * image->width + J + width] && image->pixels[I * image->width + J + width].a != 0; ++width);
+            for (height = 1; I + height < image->height; ++height)
+            {
+                for (X = J; X < J + width; ++X)
+                {
+                    if (claimed[(I + height) * image->width + X] || image->pixels[(I + height) * image->width + X].a == 0)
+                        break;
+                }
+
+                if (X != J + width)
+                    break;
+            }
+
+            TemplateRegion region = {J, I, width, height, {0, 0, 0}, 0};
+            for (Y = I; Y < I + height; ++Y)
+            {
+                for (X = J; X < J + width; ++X)
+                {
+                    rgb32 *pixel = &image->pixels[Y * image->width + X];
+                    claimed[Y * image->width + X] = true;
+                    region.sum[0] += pixel->r;
+                    region.sum[1] += pixel->g;
+                    region.sum[2] += pixel->b;
+                    region.energy += pixel->r * pixel->r + pixel->g * pixel->g + pixel->b * pixel->b;
+                }
+            }
+
+            if (found < TEMPLATE_REGIONS)
+                candidates[found++] = region;
+            else if (__compareRegions(&region, &candidates[TEMPLATE_REGIONS - 1]) < 0)
+                candidates[TEMPLATE_REGIONS - 1] = region;
+            else
+                continue;
+
+            qsort(candidates, found, sizeof(TemplateRegion), &__compareRegions);
+        }
+    }
+
+    memcpy(regions->regions, candidates, found * sizeof(TemplateRegion));
+    regions->count = found;
+    free(claimed);
+    return found > 0;
+}
+
+bool createTemplate(Template *tpl, bitmap *image)
+{
+    uint32_t L;
+    memset(tpl, 0, sizeof(Template));
+    tpl->image = image;
+
+    if (!__orderAnchors(tpl, image))
+    {
+        freeTemplate(tpl);
+        return false;
+    }
+
+    createTemplateRegions(&tpl->regions, image);
+
+    for (L = 0; L < PYRAMID_LEVELS; ++L)
+    {
+        if (!__createTemplateLevel(&tpl->levels[L], image, 2 << L))
+        {
+            freeTemplate(tpl);
+            return false;
+        }
+    }
+    return true;
+}
+
+void freeTemplate(Template *tpl)
+{
+    uint32_t L;
+    for (L = 0; L < PYRAMID_LEVELS; ++L)
+    {
+        free(tpl->levels[L].blocks);
+        tpl->levels[L].blocks = NULL;
+    }
+    free(tpl->order);
+    tpl->order = NULL;
+    tpl->count = 0;
+    tpl->image = NULL;
+}
+
+FramePyramid *createFramePyramid(bitmap *image)
+{
+    uint32_t I, J, L;
+    FramePyramid *pyramid = calloc(1, sizeof(FramePyramid));
+    if (!pyramid)
+        return NULL;
+
+    for (L = 0; L < PYRAMID_LEVELS; ++L)
+    {
+        PyramidLevel *level = &pyramid->levels[L];
+        level->factor = 2 << L;
+        level->width = image->width / level->factor;
+        level->height = image->height / level->factor;
+
+        if (!(level->sums = malloc((level->width * level->height + 1) * sizeof(BlockSum))))
+        {
+            freeFramePyramid(pyramid);
+            return NULL;
+        }
+
+        /** The finest level sums 2x2 pixels; every coarser one sums 2x2 blocks of the level below. **/
+        for (I = 0; I < level->height; ++I)
+        {
+            for (J = 0; J < level->width; ++J)
+            {
+                BlockSum *sum = &level->sums[I * level->width + J];
+                if (L == 0)
+                {
+                    rgb32 *a = &image->pixels[(2 * I) * image->width + 2 * J], *b = a + image->width;
+                    sum->r = a[0].r + a[1].r + b[0].r + b[1].r;
+                    sum->g = a[0].g + a[1].g + b[0].g + b[1].g;
+                    sum->b = a[0].b + a[1].b + b[0].b + b[1].b;
+                }
+                else
+                {
+                    PyramidLevel *below = &pyramid->levels[L - 1];
+                    BlockSum *a = &below->sums[(2 * I) * below->width + 2 * J], *b = a + below->width;
+                    sum->r = a[0].r + a[1].r + b[0].r + b[1].r;
+                    sum->g = a[0].g + a[1].g + b[0].g + b[1].g;
+                    sum->b = a[0].b + a[1].b + b[0].b + b[1].b;
+                }
+                sum->a = 0;
+            }
+        }
+    }
+    return pyramid;
+}
+
+void freeFramePyramid(FramePyramid *pyramid)
+{
+    uint32_t L;
+    if (!pyramid)
+        return;
+
+    for (L = 0; L < PYRAMID_LEVELS; ++L)
+        free(pyramid->levels[L].sums);
+    free(pyramid);
+}
+
+/** A block sum differs from the template's by the sum of F * F per-pixel differences, so by the triangle
+ *  inequality a pixel-wise match within tol implies |sum difference| <= F * F * tol per channel (CTS 0)
+ *  or in Euclidean distance (CTS 1), and equal sums for exact matches (CTS -1).
+ **/
+bool matchTemplateCoarse(const Template *tpl, const FramePyramid *pyramid, int32_t x, int32_t y, int16_t CTSNum, uint16_t tolerance)
+{
+    int32_t L;
+    uint32_t K;
+
+    if (CTSNum < -1 || CTSNum > 1)
+        return true;
+
+    for (L = PYRAMID_LEVELS - 1; L >= 0; --L)
+    {
+        const TemplateLevel *level = &tpl->levels[L];
+        const PyramidLevel *frame = &pyramid->levels[L];
+        uint32_t factor = level->factor, phase = (y % factor) * factor + (x % factor);
+        const BlockSum *origin = &frame->sums[(y / factor) * frame->width + (x / factor)];
+        int64_t bound = (int64_t)factor * factor * tolerance;
+
+        for (K = level->offsets[phase]; K < level->offsets[phase + 1]; ++K)
+        {
+            const TemplateBlock *block = &level->blocks[K];
+            const BlockSum *sum = &origin[block->y * frame->width + block->x];
+            int32_t R = sum->r - block->sum.r, G = sum->g - block->sum.g, B = sum->b - block->sum.b;
+
+            if (CTSNum == -1)
+            {
+                if (R || G || B)
+                    return false;
+            }
+            else if (CTSNum == 0)
+            {
+                if (abs(R) > bound || abs(G) > bound || abs(B) > bound)
+                    return false;
+            }
+            else if ((int64_t)R * R + (int64_t)G * G + (int64_t)B * B > bound * bound)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,166 @@
+#include "threadpool.h"
+
+#include <stdlib.h>
+#include <stdatomic.h>
+#include <pthread.h>
+
+#if defined _WIN32 || defined _WIN64
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+struct ThreadPool_t
+{
+    pthread_t *threads;
+    uint32_t count;
+
+    pthread_mutex_t busy;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_cond_t done;
+
+    uint64_t generation;
+    bool stop;
+
+    TaskFunc func;
+    void *data;
+    uint32_t tasks;
+    atomic_uint next;
+    uint32_t active;
+};
+
+static uint32_t __processorCount(void)
+{
+#if defined _WIN32 || defined _WIN64
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+#else
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? count : 1;
+#endif
+}
+
+static void __runTasks(ThreadPool *pool, TaskFunc func, void *data, uint32_t tasks)
+{
+    uint32_t index;
+    while ((index = atomic_fetch_add(&pool->next, 1)) < tasks)
+        func(data, index);
+}
+
+static void *__worker(void *arg)
+{
+    ThreadPool *pool = arg;
+    uint64_t seen = 0;
+
+    pthread_mutex_lock(&pool->lock);
+    while (true)
+    {
+        while (!pool->stop && pool->generation == seen)
+            pthread_cond_wait(&pool->wake, &pool->lock);
+
+        if (pool->stop)
+            break;
+
+        seen = pool->generation;
+        TaskFunc func = pool->func;
+        void *data = pool->data;
+        uint32_t tasks = pool->tasks;
+        pthread_mutex_unlock(&pool->lock);
+
+        __runTasks(pool, func, data, tasks);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->active == 0)
+            pthread_cond_signal(&pool->done);
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool *createThreadPool(uint32_t threads)
+{
+    ThreadPool *pool = calloc(1, sizeof(ThreadPool));
+    if (!pool)
+        return NULL;
+
+    if (threads == 0)
+        threads = __processorCount();
+
+    pthread_mutex_init(&pool->busy, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wake, NULL);
+    pthread_cond_init(&pool->done, NULL);
+    atomic_init(&pool->next, 0);
+
+    if (threads > 1 && !(pool->threads = malloc((threads - 1) * sizeof(pthread_t))))
+    {
+        freeThreadPool(pool);
+        return NULL;
+    }
+
+    for (pool->count = 0; pool->count < threads - 1; ++pool->count)
+    {
+        if (pthread_create(&pool->threads[pool->count], NULL, &__worker, pool) != 0)
+            break;
+    }
+    return pool;
+}
+
+void freeThreadPool(ThreadPool *pool)
+{
+    if (!pool)
+        return;
+
+    uint32_t I;
+    pthread_mutex_lock(&pool->lock);
+    pool->stop = true;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (I = 0; I < pool->count; ++I)
+        pthread_join(pool->threads[I], NULL);
+
+    pthread_cond_destroy(&pool->done);
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->busy);
+    free(pool->threads);
+    free(pool);
+}
+
+uint32_t threadPoolSize(ThreadPool *pool)
+{
+    return pool ? pool->count + 1 : 1;
+}
+
+void parallelFor(ThreadPool *pool, uint32_t count, TaskFunc func, void *data)
+{
+    uint32_t I;
+    if (!pool || pool->count == 0 || count < 2 || pthread_mutex_trylock(&pool->busy) != 0)
+    {
+        for (I = 0; I < count; ++I)
+            func(data, I);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->func = func;
+    pool->data = data;
+    pool->tasks = count;
+    pool->active = pool->count;
+    atomic_store(&pool->next, 0);
+    ++pool->generation;
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    __runTasks(pool, func, data, count);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->active != 0)
+        pthread_cond_wait(&pool->done, &pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->busy);
+}
@@ -0,0 +1,180 @@
+#include "tilebounds.h"
+#include "framecache.h"
+
+typedef struct
+{
+    uint8_t low[3];
+    uint8_t high[3];
+    uint64_t bins[TILE_BOUNDS_BINS / 64];
+} __Tile;
+
+struct TileBounds_t
+{
+    uint32_t columns;
+    uint32_t rows;
+    __Tile *tiles;
+};
+
+static inline uint32_t __binOf(const rgb32 *px)
+{
+    return (px->r >> 5) | ((px->g >> 5) << 3) | ((px->b >> 5) << 6);
+}
+
+TileBounds *createTileBounds(bitmap *image)
+{
+    uint32_t I, J, K;
+    TileBounds *bounds = calloc(1, sizeof(TileBounds));
+    if (!bounds)
+        return NULL;
+
+    bounds->columns = (image->width + TILE_BOUNDS_SIZE - 1) / TILE_BOUNDS_SIZE;
+    bounds->rows = (image->height + TILE_BOUNDS_SIZE - 1) / TILE_BOUNDS_SIZE;
+    if (!(bounds->tiles = calloc((size_t)bounds->columns * bounds->rows + 1, sizeof(__Tile))))
+    {
+        freeTileBounds(bounds);
+        return NULL;
+    }
+
+    for (I = 0; I < bounds->columns * bounds->rows; ++I)
+        memset(bounds->tiles[I].low, 0xFF, sizeof(bounds->tiles[I].low));
+
+    for (I = 0; I < image->height; ++I)
+    {
+        const rgb32 *row = &image->pixels[I * image->width];
+        __Tile *tile = &bounds->tiles[(I / TILE_BOUNDS_SIZE) * bounds->columns];
+
+        for (J = 0; J < image->width; J += TILE_BOUNDS_SIZE, ++tile)
+        {
+            uint32_t end = J + TILE_BOUNDS_SIZE < image->width ? J + TILE_BOUNDS_SIZE : image->width;
+            uint8_t low[3] = {tile->low[0], tile->low[1], tile->low[2]};
+            uint8_t high[3] = {tile->high[0], tile->high[1], tile->high[2]};
+
+            for (K = J; K < end; ++K)
+            {
+                const rgb32 *px = &row[K];
+                low[0] = px->r < low[0] ? px->r : low[0];
+                low[1] = px->g < low[1] ? px->g : low[1];
+                low[2] = px->b < low[2] ? px->b : low[2];
+                high[0] = px->r > high[0] ? px->r : high[0];
+                high[1] = px->g > high[1] ? px->g : high[1];
+                high[2] = px->b > high[2] ? px->b : high[2];
+
+                uint32_t bin = __binOf(px);
+                tile->bins[bin >> 6] |= 1ULL << (bin & 63);
+            }
+
+            memcpy(tile->low, low, sizeof(low));
+            memcpy(tile->high, high, sizeof(high));
+        }
+    }
+    return bounds;
+}
+
+void freeTileBounds(TileBounds *bounds)
+{
+    if (!bounds)
+        return;
+
+    free(bounds->tiles);
+    free(bounds);
+}
+
+static void *__buildTileBounds(CTSInfo *info)
+{
+    return createTileBounds(info->targetImage);
+}
+
+static void __freeTileBounds(void *data)
+{
+    freeTileBounds(data);
+}
+
+const TileBounds *getTileBounds(CTSInfo *info)
+{
+    return getFrameData(info, FrameTileBoundsData, &__buildTileBounds, &__freeTileBounds);
+}
+
+/** A box of colours may hold a match if the colour closest to the searched one inside it is within tolerance. **/
+#define CTS1_MAX_TOL 442
+
+static inline int32_t __gap(int32_t value, int32_t low, int32_t high)
+{
+    return value < low ? low - value : value > high ? value - high : 0;
+}
+
+static inline bool __boxMatches(const TileQuery *query, int32_t lowR, int32_t lowG, int32_t lowB, int32_t highR, int32_t highG, int32_t highB)
+{
+    int32_t R = __gap(query->colour[0], lowR, highR);
+    int32_t G = __gap(query->colour[1], lowG, highG);
+    int32_t B = __gap(query->colour[2], lowB, highB);
+
+    if (query->euclidean)
+        return R * R + G * G + B * B <= query->tol * query->tol;
+    return R <= query->tol && G <= query->tol && B <= query->tol;
+}
+
+bool prepareTileQuery(TileQuery *query, const TileBounds *bounds, int16_t CTSNum, const rgb32 *colour, uint16_t tol)
+{
+    uint32_t I;
+    if (!bounds || CTSNum < -1 || CTSNum > 1)
+        return false;
+
+    query->bounds = bounds;
+    query->colour[0] = colour->r;
+    query->colour[1] = colour->g;
+    query->colour[2] = colour->b;
+    /** Past 442 every colour is within reach, and clamping keeps tol * tol within 32 bits as the CTS 1 kernels do. **/
+    query->tol = CTSNum == -1 ? 0 : CTSNum == 1 && tol > CTS1_MAX_TOL ? CTS1_MAX_TOL : tol;
+    query->euclidean = CTSNum == 1;
+    memset(query->bins, 0, sizeof(query->bins));
+
+    for (I = 0; I < TILE_BOUNDS_BINS; ++I)
+    {
+        int32_t R = (I & 7) << 5, G = ((I >> 3) & 7) << 5, B = (I >> 6) << 5;
+        if (__boxMatches(query, R, G, B, R + 31, G + 31, B + 31))
+            query->bins[I >> 6] |= 1ULL << (I & 63);
+    }
+    return true;
+}
+
+static inline bool __tileMatches(const TileQuery *query, const __Tile *tile)
+{
+    uint32_t I;
+    if (!__boxMatches(query, tile->low[0], tile->low[1], tile->low[2], tile->high[0], tile->high[1], tile->high[2]))
+        return false;
+
+    for (I = 0; I < TILE_BOUNDS_BINS / 64; ++I)
+    {
+        if (query->bins[I] & tile->bins[I])
+            return true;
+    }
+    return false;
+}
+
+uint32_t tileQueryRuns(const TileQuery *query, int32_t y, int32_t x1, int32_t x2, int32_t *runs)
+{
+    int32_t I;
+    uint32_t count = 0;
+    const __Tile *row = &query->bounds->tiles[(y / TILE_BOUNDS_SIZE) * query->bounds->columns];
+
+    for (I = x1 / TILE_BOUNDS_SIZE; I * TILE_BOUNDS_SIZE < x2; ++I)
+    {
+        if (!__tileMatches(query, &row[I]))
+            continue;
+
+        int32_t start = I * TILE_BOUNDS_SIZE > x1 ? I * TILE_BOUNDS_SIZE : x1;
+        int32_t end = (I + 1) * TILE_BOUNDS_SIZE < x2 ? (I + 1) * TILE_BOUNDS_SIZE : x2;
+
+        if (count && runs[count * 2 - 1] == start)
+        {
+            runs[count * 2 - 1] = end;
+        }
+        else
+        {
+            runs[count * 2] = start;
+            runs[count * 2 + 1] = end;
+            ++count;
+        }
+    }
+    return count;
+}